@@ -0,0 +1,146 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	backlight.c
+ *
+ *	LCD backlight brightness and fades, on the 10-bit PWM of timer 4.
+ */
+#if !BACKLIGHT_HOST_MODEL
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#endif
+
+#include "backlight.h"
+
+/*
+ *  Fade state, owned by the interrupt handler while a fade is running.
+ */
+static volatile uint16_t level;
+static volatile uint16_t target;
+static volatile bool fading;
+static uint16_t rate;
+static uint16_t remainder;
+static uint8_t curve;
+
+#if BACKLIGHT_HOST_MODEL
+uint16_t backlight_model_duty;
+
+static void write_duty(uint16_t duty) {
+	backlight_model_duty = duty;
+}
+
+static void enable_tick(bool enable) {
+}
+
+#define ATOMIC_BLOCK(type)
+#else
+static void write_duty(uint16_t duty) {
+	// The high byte goes through TC4H, which OCR4A takes as it is written.
+	TC4H = duty >> 8;
+	OCR4A = duty & 0xff;
+}
+
+static void enable_tick(bool enable) {
+	if ( enable ) {
+		TIFR4 = (1 << TOV4);
+		TIMSK4 |= (1 << TOIE4);
+	}
+	else {
+		TIMSK4 &= ~(1 << TOIE4);
+	}
+}
+
+ISR(TIMER4_OVF_vect) {
+	backlight_tick();
+}
+#endif
+
+void backlight_init(void) {
+	backlight_set(0, BACKLIGHT_LINEAR);
+
+#if !BACKLIGHT_HOST_MODEL
+	TC4H = BACKLIGHT_MAX >> 8;
+	OCR4C = BACKLIGHT_MAX & 0xff;
+
+	// PWM on OC4A, prescaler 64
+	TCCR4A = (1 << COM4A1) | (1 << PWM4A);
+	DDRC |= (1 << 7);
+	TCCR4B = (1 << CS42) | (1 << CS41) | (1 << CS40);
+	TCCR4D = 0;
+#endif
+}
+
+uint16_t backlight_duty(uint16_t level, uint8_t curve) {
+	if ( curve == BACKLIGHT_SQUARE ) {
+		return (uint32_t) level * level / BACKLIGHT_MAX;
+	}
+	return level;
+}
+
+void backlight_set(uint16_t new_level, uint8_t new_curve) {
+	if ( new_level > BACKLIGHT_MAX ) {
+		new_level = BACKLIGHT_MAX;
+	}
+
+	enable_tick(false);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		fading = false;
+		level = new_level;
+		target = new_level;
+		curve = new_curve;
+		write_duty(backlight_duty(new_level, new_curve));
+	}
+}
+
+void backlight_fade(uint16_t new_target, uint16_t new_rate, uint8_t new_curve) {
+	if ( new_target > BACKLIGHT_MAX ) {
+		new_target = BACKLIGHT_MAX;
+	}
+
+	enable_tick(false);
+	target = new_target;
+	rate = new_rate;
+	remainder = 0;
+	curve = new_curve;
+	fading = true;
+	enable_tick(true);
+}
+
+bool backlight_fading(void) {
+	return fading;
+}
+
+uint16_t backlight_level(void) {
+	uint16_t now;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		now = level;
+	}
+
+	return now;
+}
+
+void backlight_tick(void) {
+	if ( !fading ) {
+		return;
+	}
+
+	// Levels this tick, the fraction carried over to the next one.
+	uint32_t total = (uint32_t) remainder + rate;
+	uint16_t step = total / BACKLIGHT_TICK_HZ;
+	remainder = total - (uint32_t) step * BACKLIGHT_TICK_HZ;
+
+	if ( level < target ) {
+		level = target - level > step ? level + step : target;
+	}
+	else if ( level > target ) {
+		level = level - target > step ? level - step : target;
+	}
+
+	write_duty(backlight_duty(level, curve));
+
+	if ( level == target ) {
+		fading = false;
+		enable_tick(false);
+	}
+}
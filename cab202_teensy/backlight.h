@@ -0,0 +1,98 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	backlight.h
+ *
+ *	LCD backlight brightness and fades, on the 10-bit PWM of timer 4
+ *	(OC4A, PC7).
+ *
+ *	A fade moves the level towards its target at a fixed rate from the
+ *	timer 4 overflow interrupt, about 122 times a second, so it runs in
+ *	the background at the same speed however long the main loop takes.
+ *	The interrupt is only enabled while a fade is running.
+ *
+ *	Built with -DBACKLIGHT_HOST_MODEL=1, the file compiles on the host
+ *	with no AVR headers: the duty is written to backlight_model_duty in
+ *	place of OCR4A, and a test calls backlight_tick for each overflow of
+ *	timer 4. The PWM output is high for backlight_model_duty of every
+ *	BACKLIGHT_MAX + 1 timer counts. F_CPU is the Teensy's 8 MHz unless the
+ *	test sets it. make test checks the model with backlight_test.c.
+ */
+#ifndef BACKLIGHT_H_
+#define BACKLIGHT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if BACKLIGHT_HOST_MODEL && !defined(F_CPU)
+#define F_CPU 8000000UL
+#endif
+
+/*
+ *  Highest level and duty, the top of the timer 4 count.
+ */
+#define BACKLIGHT_MAX 1023
+
+/*
+ *  Overflows of timer 4 a second, each one a step of a fade.
+ */
+#define BACKLIGHT_TICK_HZ (F_CPU / 64 / (BACKLIGHT_MAX + 1))
+
+/*
+ *  How the level is turned into the duty of the PWM.
+ */
+typedef enum backlight_curve_t {
+	BACKLIGHT_LINEAR = 0,	// the duty is the level
+	BACKLIGHT_SQUARE = 1,	// the duty is level * level / BACKLIGHT_MAX, so
+							// even steps of level look even to the eye
+} backlight_curve_t;
+
+#if BACKLIGHT_HOST_MODEL
+extern uint16_t backlight_model_duty;
+#endif
+
+/*
+ *  Set up timer 4 for 10-bit PWM on OC4A at level 0.
+ */
+void backlight_init(void);
+
+/*
+ *  Stop any fade and set the level at once.
+ *
+ *	Parameters:
+ *		level - 0 to BACKLIGHT_MAX.
+ *		curve - A backlight_curve_t.
+ */
+void backlight_set(uint16_t level, uint8_t curve);
+
+/*
+ *  Start fading from the current level to a new one.
+ *
+ *	Parameters:
+ *		target - The level to end at, 0 to BACKLIGHT_MAX.
+ *		rate - Levels a second.
+ *		curve - A backlight_curve_t, used from now on.
+ */
+void backlight_fade(uint16_t target, uint16_t rate, uint8_t curve);
+
+/*
+ *  Get if a fade is still running.
+ */
+bool backlight_fading(void);
+
+/*
+ *  Get the current level.
+ */
+uint16_t backlight_level(void);
+
+/*
+ *  Get the duty of a level on a curve.
+ */
+uint16_t backlight_duty(uint16_t level, uint8_t curve);
+
+/*
+ *  Take one step of the fade and write the duty, called by the timer 4
+ *	overflow interrupt.
+ */
+void backlight_tick(void);
+
+#endif /* BACKLIGHT_H_ */
@@ -0,0 +1,106 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	backlight_test.c
+ *
+ *	Checks of the backlight fades on the host model, run on the computer
+ *	with
+ *
+ *		make test
+ *
+ *	Every fade is run a tick at a time on each curve. It must move the
+ *	level one way only, end on its target with the duty of the target,
+ *	and end on the tick its rate says: the fraction of a level left over
+ *	each tick is carried to the next, so a fade over d levels at r levels
+ *	a second takes exactly d * BACKLIGHT_TICK_HZ / r ticks, rounded up.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "backlight.h"
+
+/*
+ *  Most ticks a fade is run for, a little over the slowest one checked.
+ */
+#define TICKS_MAX (BACKLIGHT_MAX * BACKLIGHT_TICK_HZ + 1)
+
+static int checks, failures;
+
+static void check(bool ok, const char *what, uint16_t from, uint16_t to, uint16_t rate, uint8_t curve) {
+	checks++;
+	if ( !ok ) {
+		failures++;
+		printf("fade %u to %u at %u a second on curve %u: %s\n", from, to, rate, curve, what);
+	}
+}
+
+/*
+ *  Run one fade and check it.
+ */
+static void check_fade(uint16_t from, uint16_t to, uint16_t rate, uint8_t curve) {
+	uint32_t distance = from < to ? to - from : from - to;
+	uint32_t expected = (distance * BACKLIGHT_TICK_HZ + rate - 1) / rate;
+	uint32_t ticks = 0;
+	uint16_t last = from;
+	bool one_way = true;
+
+	backlight_set(from, curve);
+	backlight_fade(to, rate, curve);
+	while ( backlight_fading() && ticks < TICKS_MAX ) {
+		backlight_tick();
+		ticks++;
+
+		uint16_t now = backlight_level();
+		one_way = one_way && (from < to ? now >= last : now <= last);
+		last = now;
+	}
+
+	check(!backlight_fading(), "never ends", from, to, rate, curve);
+	check(one_way, "turns back", from, to, rate, curve);
+	check(backlight_level() == to, "ends off its target", from, to, rate, curve);
+	check(backlight_model_duty == backlight_duty(to, curve), "ends on the wrong duty", from, to, rate, curve);
+	// a fade to where it is ends on its first tick
+	check(ticks == (distance == 0 ? 1 : expected), "ends on the wrong tick", from, to, rate, curve);
+}
+
+int main(void) {
+	static const uint16_t levels[] = { 0, 1, 300, 512, BACKLIGHT_MAX };
+	static const uint16_t rates[] = { 1, 100, 300, BACKLIGHT_MAX, 5000, UINT16_MAX };
+	const int level_count = sizeof(levels) / sizeof(levels[0]);
+	const int rate_count = sizeof(rates) / sizeof(rates[0]);
+
+	// timer 4 at 8 MHz / 64 overflows every 1024 counts
+	check(BACKLIGHT_TICK_HZ == 122, "does not tick 122 times a second", 0, 0, 0, 0);
+
+	backlight_init();
+	check(backlight_level() == 0 && backlight_model_duty == 0, "does not start dark", 0, 0, 0, 0);
+
+	// both curves run from dark to full
+	for ( uint8_t curve = BACKLIGHT_LINEAR; curve <= BACKLIGHT_SQUARE; curve++ ) {
+		check(backlight_duty(0, curve) == 0, "is not dark at level 0", 0, 0, 0, curve);
+		check(backlight_duty(BACKLIGHT_MAX, curve) == BACKLIGHT_MAX, "is not full at the top level",
+			0, 0, 0, curve);
+	}
+
+	// levels past the top are the top
+	backlight_set(BACKLIGHT_MAX + 1, BACKLIGHT_LINEAR);
+	check(backlight_level() == BACKLIGHT_MAX, "sets a level past the top", 0, 0, 0, 0);
+	backlight_set(0, BACKLIGHT_LINEAR);
+	backlight_fade(UINT16_MAX, UINT16_MAX, BACKLIGHT_LINEAR);
+	for ( int i = 0; i < BACKLIGHT_TICK_HZ && backlight_fading(); i++ ) {
+		backlight_tick();
+	}
+	check(backlight_level() == BACKLIGHT_MAX, "fades past the top", 0, UINT16_MAX, UINT16_MAX, 0);
+
+	for ( uint8_t curve = BACKLIGHT_LINEAR; curve <= BACKLIGHT_SQUARE; curve++ ) {
+		for ( int f = 0; f < level_count; f++ ) {
+			for ( int t = 0; t < level_count; t++ ) {
+				for ( int r = 0; r < rate_count; r++ ) {
+					check_fade(levels[f], levels[t], rates[r], curve);
+				}
+			}
+		}
+	}
+
+	printf("backlight_test: %d checks, %d failed\n", checks, failures);
+	return failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -7,6 +7,8 @@
 **			this version: Lawrence Buckingham, October 2017.
 */
 
+#include <avr/interrupt.h>
+
 #include "cab202_adc.h"
 
 /*
@@ -51,3 +53,95 @@ uint16_t adc_read(uint8_t channel) {
 	return ADC;
 }
 
+/*
+**	State of the background sampling, owned by the conversion complete ISR.
+**	Filtered values keep 4 fractional bits.
+*/
+#define ADC_FILTER_FRACTION 4
+
+static volatile uint8_t adc_channels;
+static volatile uint16_t adc_values[8];
+static uint8_t adc_channel;
+static uint8_t adc_samples;
+static uint16_t adc_sum;
+static uint8_t adc_primed;
+static int16_t adc_filtered[8];
+
+/*
+**	Select the channel for the next conversion and start it.
+*/
+static void adc_start_conversion(uint8_t channel) {
+	ADMUX = channel | (1 << REFS0);
+	ADCSRB = 0;
+	ADCSRA |= (1 << ADSC);
+}
+
+void adc_start_sampling(uint8_t channels) {
+	if ( channels == 0 ) {
+		return;
+	}
+
+	adc_channels = channels;
+	adc_samples = 0;
+	adc_sum = 0;
+	adc_primed = 0;
+
+	// Start from the lowest channel in the mask.
+	adc_channel = 0;
+	while ( !(channels & (1 << adc_channel)) ) {
+		adc_channel++;
+	}
+
+	// Enable the conversion complete interrupt and start the first conversion.
+	ADCSRA |= (1 << ADIE);
+	adc_start_conversion(adc_channel);
+}
+
+/*
+**	Conversion complete: accumulate the result, publish a filtered value once
+**	ADC_OVERSAMPLE results of the channel are in, and start the next one.
+*/
+ISR(ADC_vect) {
+	uint8_t channel = adc_channel;
+
+	adc_sum += ADC;
+
+	if ( ++adc_samples >= ADC_OVERSAMPLE ) {
+		int16_t sample = (adc_sum / ADC_OVERSAMPLE) << ADC_FILTER_FRACTION;
+
+		// The first sample of a channel starts the filter off.
+		if ( adc_primed & (1 << channel) ) {
+			adc_filtered[channel] += (sample - adc_filtered[channel]) / (1 << ADC_FILTER_SHIFT);
+		}
+		else {
+			adc_filtered[channel] = sample;
+			adc_primed |= (1 << channel);
+		}
+
+		adc_values[channel] = (adc_filtered[channel] + (1 << (ADC_FILTER_FRACTION - 1))) >> ADC_FILTER_FRACTION;
+
+		adc_samples = 0;
+		adc_sum = 0;
+
+		// Move on to the next channel in the mask.
+		do {
+			channel = (channel + 1) & 7;
+		} while ( !(adc_channels & (1 << channel)) );
+
+		adc_channel = channel;
+	}
+
+	adc_start_conversion(channel);
+}
+
+uint16_t adc_latest(uint8_t channel) {
+	uint16_t value;
+
+	// The ISR may publish a new value between the two byte loads, so load
+	// until two reads agree. ISRs do not nest, so this settles at once.
+	do {
+		value = adc_values[channel];
+	} while ( value != adc_values[channel] );
+
+	return value;
+}
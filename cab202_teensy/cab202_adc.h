@@ -35,3 +35,35 @@ void adc_init();
 **	4 = Broken-out Pin F4.
 */
 uint16_t adc_read(uint8_t channel);
+
+/*
+**	Number of conversions averaged into each sample taken in the background,
+**	and the strength of the filter applied to the samples. Each new sample
+**	moves the published value 1/(2^ADC_FILTER_SHIFT) of the way towards it.
+*/
+#define ADC_OVERSAMPLE		4
+#define ADC_FILTER_SHIFT	2
+
+/*
+**	Convert the designated channels over and over in the background.
+**
+**	Each conversion complete interrupt takes the result and starts the next
+**	conversion, moving round-robin through the channels. Every ADC_OVERSAMPLE
+**	conversions of a channel are averaged and filtered, and the result is
+**	published for adc_latest. adc_init must be called first and interrupts
+**	must be enabled. Do not call adc_read while background sampling runs.
+**
+**	Input:
+**	channels - A bit mask of the channels to sample, bit n for channel n.
+**			   Only channels 0 to 7 can be sampled in the background.
+*/
+void adc_start_sampling(uint8_t channels);
+
+/*
+**	Get the latest filtered value of a channel sampled in the background.
+**	This does not wait for a conversion, it only reads the published value.
+**
+**	Input:
+**	channel - A channel included in the mask given to adc_start_sampling.
+*/
+uint16_t adc_latest(uint8_t channel);
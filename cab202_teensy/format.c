@@ -0,0 +1,110 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	format.c
+ *
+ *	Number formatting without printf, for the LCD and the serial port.
+ */
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+
+#include "format.h"
+
+/*
+ *  The place values of a uint32_t, largest first.
+ */
+static const uint32_t place_values[10] PROGMEM = {
+	1000000000, 100000000, 10000000, 1000000, 100000,
+	10000, 1000, 100, 10, 1
+};
+
+/*
+ *  Add a char to the text if there is room for it and the '\0'.
+ */
+static uint8_t append(char *text, uint8_t size, uint8_t length, char c) {
+	if ( length + 1 < size ) {
+		text[length++] = c;
+		text[length] = '\0';
+	}
+	return length;
+}
+
+uint8_t format_uint(char *text, uint8_t size, uint32_t value, uint8_t width) {
+	uint8_t length = 0;
+	bool started = false;
+
+	if ( size == 0 ) {
+		return 0;
+	}
+	text[0] = '\0';
+
+	for ( uint8_t p = 0; p < 10; p++ ) {
+		uint32_t place = pgm_read_dword(&place_values[p]);
+		char digit = '0';
+
+		// Most numbers are small, so skip the places above them quickly.
+		if ( !started && value < place && 10 - p > width && p < 9 ) {
+			continue;
+		}
+
+		while ( value >= place ) {
+			value -= place;
+			digit++;
+		}
+
+		started = true;
+		length = append(text, size, length, digit);
+	}
+
+	return length;
+}
+
+uint8_t format_int(char *text, uint8_t size, int32_t value, uint8_t width) {
+	uint8_t length = 0;
+
+	if ( size == 0 ) {
+		return 0;
+	}
+	text[0] = '\0';
+
+	if ( value < 0 ) {
+		length = append(text, size, length, '-');
+		// As unsigned, so the most negative int32_t works too.
+		return length + format_uint(text + length, size - length, -(uint32_t) value, width);
+	}
+
+	return format_uint(text, size, value, width);
+}
+
+uint8_t format_fixed(char *text, uint8_t size, int32_t value, uint8_t decimals) {
+	char digits[FORMAT_INT_SIZE];
+	uint8_t length = 0;
+
+	if ( size == 0 ) {
+		return 0;
+	}
+	text[0] = '\0';
+
+	if ( value < 0 ) {
+		length = append(text, size, length, '-');
+	}
+
+	// At least one digit in front of the point.
+	uint32_t magnitude = value < 0 ? -(uint32_t) value : (uint32_t) value;
+	uint8_t count = format_uint(digits, sizeof(digits), magnitude, decimals + 1);
+
+	for ( uint8_t i = 0; i < count; i++ ) {
+		if ( decimals > 0 && i == count - decimals ) {
+			length = append(text, size, length, '.');
+		}
+		length = append(text, size, length, digits[i]);
+	}
+
+	return length;
+}
+
+uint8_t format_time(char *text, uint8_t size, uint16_t seconds) {
+	uint8_t length = format_uint(text, size, seconds / 60, 2);
+
+	length = append(text, size, length, ':');
+	return length + format_uint(text + length, size - length, seconds % 60, 2);
+}
@@ -0,0 +1,66 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	format.h
+ *
+ *	Number formatting without printf, for the LCD and the serial port.
+ *
+ *	Every function writes into a buffer of the size it is given and never
+ *	past it: the text is cut short if it does not fit, and is always
+ *	ended with '\0'. Each returns the number of chars written, not
+ *	counting the '\0', so the text can be passed straight on to
+ *	usb_serial_write or draw_string.
+ *
+ *	Digits are found by subtracting place values, so formatting an int
+ *	needs no division.
+ */
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <stdint.h>
+
+/*
+ *  Size of a buffer that holds any int32_t, with its sign and the '\0'.
+ */
+#define FORMAT_INT_SIZE 12
+
+/*
+ *  Write a number in decimal.
+ *
+ *	Parameters:
+ *		text - Where the text is written.
+ *		size - The size of text.
+ *		value - The number.
+ *		width - The least number of digits, padded with '0'.
+ *
+ *	Returns the number of chars written.
+ */
+uint8_t format_uint(char *text, uint8_t size, uint32_t value, uint8_t width);
+uint8_t format_int(char *text, uint8_t size, int32_t value, uint8_t width);
+
+/*
+ *  Write a fixed-point number, e.g. 1234 with 2 decimals is "12.34" and
+ *	-5 with 2 decimals is "-0.05".
+ *
+ *	Parameters:
+ *		text - Where the text is written.
+ *		size - The size of text.
+ *		value - The number times 10 to the power of decimals.
+ *		decimals - The number of decimal places, at most 9.
+ *
+ *	Returns the number of chars written.
+ */
+uint8_t format_fixed(char *text, uint8_t size, int32_t value, uint8_t decimals);
+
+/*
+ *  Write a time as "mm:ss", with more minute digits past 99 minutes.
+ *
+ *	Parameters:
+ *		text - Where the text is written.
+ *		size - The size of text, 6 holds any time under 100 minutes.
+ *		seconds - The time.
+ *
+ *	Returns the number of chars written.
+ */
+uint8_t format_time(char *text, uint8_t size, uint16_t seconds);
+
+#endif /* FORMAT_H_ */
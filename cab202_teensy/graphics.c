@@ -11,6 +11,7 @@
 */
 #include <avr/pgmspace.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "graphics.h"
 #include "macros.h"
@@ -21,6 +22,31 @@
  */
 uint8_t screen_buffer[LCD_BUFFER_SIZE];
 
+/*
+ *  Columns drawn in each bank since the last clear, for clear_dirty.
+ *	A bank is clean when dirty_left > dirty_right.
+ */
+static uint8_t dirty_left[LCD_Y / 8] = { 0, 0, 0, 0, 0, 0 };
+static uint8_t dirty_right[LCD_Y / 8] = { LCD_X - 1, LCD_X - 1, LCD_X - 1, LCD_X - 1, LCD_X - 1, LCD_X - 1 };
+
+/*
+ *  Note that columns left to right of a bank have been drawn.
+ */
+static inline void mark_dirty(uint8_t bank, uint8_t left, uint8_t right) {
+	if ( left < dirty_left[bank] ) dirty_left[bank] = left;
+	if ( right > dirty_right[bank] ) dirty_right[bank] = right;
+}
+
+/*
+ *  Note that the whole screen buffer is clean, or has all been drawn.
+ */
+static void reset_dirty(uint8_t clean) {
+	for ( uint8_t bank = 0; bank < LCD_Y / 8; bank++ ) {
+		dirty_left[bank] = clean ? LCD_X : 0;
+		dirty_right[bank] = clean ? 0 : LCD_X - 1;
+	}
+}
+
 /*
  *  Copy the contents of the screen buffer to the LCD.
  *	This is the only function that interfaces with the LCD hardware
@@ -40,9 +66,160 @@ void show_screen(void) {
  * Clear the screen buffer (all pixels set to BG_COLOUR).
  */
 void clear_screen(void) {
-	// Set every byte in the buffer to 0b00000000
-	for ( int i = 0; i < LCD_BUFFER_SIZE; i++ ) {
-		screen_buffer[i] = 0;
+	// Set every byte in the buffer to 0b00000000, avr-libc's memset is a
+	// two instruction loop
+	memset(screen_buffer, 0, LCD_BUFFER_SIZE);
+	reset_dirty(1);
+}
+
+/*
+ * Clear only the columns of each bank drawn since the last clear.
+ */
+void clear_dirty(void) {
+	for ( uint8_t bank = 0; bank < LCD_Y / 8; bank++ ) {
+		if ( dirty_left[bank] <= dirty_right[bank] ) {
+			memset(&screen_buffer[bank * LCD_X + dirty_left[bank]], 0,
+				dirty_right[bank] - dirty_left[bank] + 1);
+		}
+	}
+	reset_dirty(1);
+}
+
+/*
+ * Note a rectangle written into screen_buffer directly.
+ */
+void mark_drawn(int left, int top, int right, int bottom) {
+	if ( left < 0 ) left = 0;
+	if ( top < 0 ) top = 0;
+	if ( right >= LCD_X ) right = LCD_X - 1;
+	if ( bottom >= LCD_Y ) bottom = LCD_Y - 1;
+	if ( left > right || top > bottom ) {
+		return;
+	}
+
+	for ( uint8_t bank = top >> 3; bank <= bottom >> 3; bank++ ) {
+		mark_dirty(bank, left, right);
+	}
+}
+
+/*
+ * Set every byte of the screen buffer to pattern.
+ */
+void fill_screen(uint8_t pattern) {
+	memset(screen_buffer, pattern, LCD_BUFFER_SIZE);
+	reset_dirty(pattern == 0);
+}
+
+/*
+ * Copy the screen buffer out to copy, or back in from copy.
+ */
+void save_screen(uint8_t *copy) {
+	memcpy(copy, screen_buffer, LCD_BUFFER_SIZE);
+}
+
+void restore_screen(const uint8_t *copy) {
+	memcpy(screen_buffer, copy, LCD_BUFFER_SIZE);
+	reset_dirty(0);
+}
+
+/*
+ * Invert every pixel of the screen buffer.
+ */
+void invert_screen(void) {
+	uint8_t *p = screen_buffer;
+	uint8_t *end = screen_buffer + LCD_BUFFER_SIZE;
+
+	// four bytes per pass, LCD_BUFFER_SIZE is a multiple of 4
+	while ( p < end ) {
+		*p = ~*p; p++;
+		*p = ~*p; p++;
+		*p = ~*p; p++;
+		*p = ~*p; p++;
+	}
+	reset_dirty(0);
+}
+
+/*
+ * Rectangle operations, applied a bank at a time with a mask of the rows
+ * of the rectangle in that bank.
+ */
+#define RECT_SET 0
+#define RECT_CLEAR 1
+#define RECT_INVERT 2
+
+static void apply_rect(int x, int y, int width, int height, uint8_t op) {
+	// Clip to the screen
+	if ( x < 0 ) { width += x; x = 0; }
+	if ( y < 0 ) { height += y; y = 0; }
+	if ( x + width > LCD_X ) width = LCD_X - x;
+	if ( y + height > LCD_Y ) height = LCD_Y - y;
+	if ( width <= 0 || height <= 0 ) {
+		return;
+	}
+
+	uint8_t bottom = y + height - 1;
+
+	for ( uint8_t bank = y >> 3; bank <= bottom >> 3; bank++ ) {
+		uint8_t mask = 0xFF;
+		uint8_t *p = &screen_buffer[bank * LCD_X + x];
+
+		if ( bank == y >> 3 ) mask &= 0xFF << (y & 7);
+		if ( bank == bottom >> 3 ) mask &= 0xFF >> (7 - (bottom & 7));
+
+		if ( op == RECT_SET ) {
+			for ( uint8_t i = width; i > 0; i--, p++ ) *p |= mask;
+			mark_dirty(bank, x, x + width - 1);
+		}
+		else if ( op == RECT_CLEAR ) {
+			for ( uint8_t i = width; i > 0; i--, p++ ) *p &= ~mask;
+		}
+		else {
+			for ( uint8_t i = width; i > 0; i--, p++ ) *p ^= mask;
+			mark_dirty(bank, x, x + width - 1);
+		}
+	}
+}
+
+void fill_rect(int x, int y, int width, int height, colour_t colour) {
+	apply_rect(x, y, width, height, colour ? RECT_SET : RECT_CLEAR);
+}
+
+void invert_rect(int x, int y, int width, int height) {
+	apply_rect(x, y, width, height, RECT_INVERT);
+}
+
+/*
+ * XOR a bitmap in screen layout into the screen buffer. Each source byte
+ * lands across two banks unless y is a multiple of 8.
+ */
+void xor_blit(int x, int y, int width, int height, const uint8_t *bitmap) {
+	uint8_t banks = (height + 7) >> 3;
+	uint8_t shift = y & 7;
+	int first = (y - shift) / 8;
+
+	for ( uint8_t b = 0; b < banks; b++ ) {
+		uint8_t mask = 0xFF;
+		int upper = first + b;
+
+		// Only the rows of the bitmap in its last bank
+		if ( b == banks - 1 && (height & 7) ) mask = 0xFF >> (8 - (height & 7));
+
+		for ( int i = 0; i < width; i++ ) {
+			int column = x + i;
+			uint16_t bits = (uint16_t) (bitmap[b * width + i] & mask) << shift;
+
+			if ( column < 0 || column >= LCD_X || bits == 0 ) {
+				continue;
+			}
+			if ( upper >= 0 && upper < LCD_Y / 8 ) {
+				screen_buffer[upper * LCD_X + column] ^= bits & 0xFF;
+				mark_dirty(upper, column, column);
+			}
+			if ( (bits >> 8) && upper + 1 >= 0 && upper + 1 < LCD_Y / 8 ) {
+				screen_buffer[(upper + 1) * LCD_X + column] ^= bits >> 8;
+				mark_dirty(upper + 1, column, column);
+			}
+		}
 	}
 }
 
@@ -70,6 +247,7 @@ void draw_pixel(int x, int y, colour_t colour) {
 	if ( colour ) {
 		// Draw Pixel
 		screen_buffer[bank*LCD_X + x] |= (1 << pixel);
+		mark_dirty(bank, x, x);
 	}
 	else {
 		// Erase Pixel
@@ -176,3 +354,14 @@ void draw_string(int top_left_x, int top_left_y, char *text, colour_t colour) {
 		// (see lcd.c for a hint on how to do this)
 	}
 }
+
+/**
+ *	Render a string stored in flash into the screen buffer.
+ */
+void draw_string_P(int top_left_x, int top_left_y, const char *text, colour_t colour) {
+	char c;
+
+	for ( uint8_t x = top_left_x; (c = pgm_read_byte(text)) != 0; x += CHAR_WIDTH, text++ ) {
+		draw_char(x, top_left_y, c, colour);
+	}
+}
@@ -49,6 +49,60 @@ void show_screen(void);
  */
 void clear_screen(void);
 
+/*
+ * Clear only the columns of each 8 pixel bank drawn since the last clear,
+ * which is much less than the whole buffer in most frames. The result is
+ * the same as clear_screen as long as every write to screen_buffer goes
+ * through the functions here.
+ */
+void clear_dirty(void);
+
+/*
+ * Note that pixels from (left, top) to (right, bottom) were written into
+ * screen_buffer directly, so clear_dirty clears them too.
+ */
+void mark_drawn(int left, int top, int right, int bottom);
+
+/*
+ * Set every byte of the screen buffer to pattern (8 vertical pixels).
+ */
+void fill_screen(uint8_t pattern);
+
+/*
+ * Copy the screen buffer to copy (LCD_BUFFER_SIZE bytes), or back from it.
+ */
+void save_screen(uint8_t *copy);
+void restore_screen(const uint8_t *copy);
+
+/*
+ * Invert every pixel of the screen buffer.
+ */
+void invert_screen(void);
+
+/**
+ *	Set, erase or invert every pixel of a rectangle, a byte at a time.
+ *	Parts of the rectangle off the screen are left out.
+ *
+ *	Parameters:
+ *		x, y - The top-left corner of the rectangle.
+ *		width, height - The size of the rectangle in pixels.
+ *		colour - The colour, FG_COLOUR or BG_COLOUR.
+ */
+void fill_rect(int x, int y, int width, int height, colour_t colour);
+void invert_rect(int x, int y, int width, int height);
+
+/**
+ *	XOR a bitmap into the screen buffer, so drawing it twice erases it.
+ *	The bitmap is laid out like screen_buffer: width bytes for each 8 rows,
+ *	bit 0 the top row of each byte.
+ *
+ *	Parameters:
+ *		x, y - The top-left corner of the bitmap on the screen.
+ *		width, height - The size of the bitmap in pixels.
+ *		bitmap - (height + 7) / 8 * width bytes.
+ */
+void xor_blit(int x, int y, int width, int height, const uint8_t *bitmap);
+
 /**
  *	Draw (or erase) a designated pixel in the screen buffer.
  *
@@ -101,4 +155,19 @@ void draw_char(int top_left_x, int top_left_y, char character, colour_t colour);
  */
 void draw_string(int top_left_x, int top_left_y, char *text, colour_t colour);
 
+/**
+ *	Render a string stored in flash (e.g. with PSTR) into the screen buffer,
+ *	without first copying it to RAM.
+ *
+ *	Parameters:
+ *		x - The horizontal position of the top-left corner of the displayed
+ *			text.
+ *		y - The vertical position of the top-left corner of the displayed
+ *			text.
+ *		text - The address in flash of the string to render.
+ *		colour - The colour, FG_COLOUR or BG_COLOUR. If colour is BG_COLOUR,
+ *			the text is rendered as an inverse video block.
+ */
+void draw_string_P(int top_left_x, int top_left_y, const char *text, colour_t colour);
+
 #endif /* GRAPHICS_H_ */
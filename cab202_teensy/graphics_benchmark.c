@@ -0,0 +1,274 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	graphics_benchmark.c
+ *
+ *	Cycle counts of the graphics and lcd functions, run under simavr with
+ *
+ *		make benchmark > benchmark.json
+ *
+ *	Timer 1 counts at the CPU clock, so every count is exact. The cost of
+ *	calling an empty function and reading the timer is measured first and
+ *	taken off every result. The results are written to the simavr console
+ *	as JSON, one line at a time, so the output of two commits can be
+ *	diffed.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+
+#include "avr_mcu_section.h"
+#include "graphics.h"
+#include "lcd.h"
+
+AVR_MCU(F_CPU, "atmega32u4");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+/*
+ *  Number of times each function is called.
+ */
+#define BENCHMARK_CALLS 64
+
+/*
+ *  One function under test. run is called with the number of the call, so
+ *	the arguments can vary from call to call.
+ */
+typedef struct benchmark_t {
+	const char *name;		// in flash
+	void (*run)(uint8_t i);
+} benchmark_t;
+
+static volatile uint16_t timer_overflows;
+
+ISR(TIMER1_OVF_vect) {
+	timer_overflows++;
+}
+
+/*
+ *  Get the cycles counted by timer 1 since it was started.
+ */
+static uint32_t read_cycles(void) {
+	uint16_t high, low;
+
+	cli();
+	low = TCNT1;
+	high = timer_overflows;
+	// The timer wrapped after interrupts were held off.
+	if ( (TIFR1 & (1 << TOV1)) && low < 0x8000 ) {
+		high++;
+	}
+	sei();
+
+	return ((uint32_t) high << 16) | low;
+}
+
+/*
+ *  Write to the simavr console, which prints a line at each newline.
+ */
+static void console_putc(char c) {
+	GPIOR0 = c;
+}
+
+static void console_puts_P(const char *s) {
+	char c;
+
+	while ( (c = pgm_read_byte(s++)) != 0 ) {
+		console_putc(c);
+	}
+}
+
+static void console_putu(uint32_t value) {
+	char digits[11];
+
+	ultoa(value, digits, 10);
+	for ( char *c = digits; *c != 0; c++ ) {
+		console_putc(*c);
+	}
+}
+
+/*
+ *  The functions under test.
+ */
+static void run_nothing(uint8_t i) {
+}
+
+static void run_draw_pixel(uint8_t i) {
+	draw_pixel(i % LCD_X, i % LCD_Y, FG_COLOUR);
+}
+
+static void run_draw_line(uint8_t i) {
+	draw_line(0, 0, LCD_X - 1, i % LCD_Y, FG_COLOUR);
+}
+
+static void run_draw_char(uint8_t i) {
+	draw_char(i % (LCD_X - 5), 8, 'A' + i % 26, FG_COLOUR);
+}
+
+static void run_draw_string(uint8_t i) {
+	draw_string(i % 16, 16, "Score: 1234", FG_COLOUR);
+}
+
+static void run_clear_screen(uint8_t i) {
+	clear_screen();
+}
+
+static void run_show_screen(uint8_t i) {
+	show_screen();
+}
+
+static void run_lcd_write(uint8_t i) {
+	lcd_write(LCD_D, i);
+}
+
+static void run_fill_rect(uint8_t i) {
+	fill_rect(i % 8, i % 8, 16, 16, FG_COLOUR);
+}
+
+static void run_xor_blit(uint8_t i) {
+	static const uint8_t sprite[] = { 0x0E, 0x1F, 0x3F, 0x3F, 0x1F, 0x0E, 0x04 };
+
+	xor_blit(i % (LCD_X - 7), i % (LCD_Y - 7), 7, 7, sprite);
+}
+
+static void run_invert_screen(uint8_t i) {
+	invert_screen();
+}
+
+static void run_clear_dirty(uint8_t i) {
+	clear_dirty();
+}
+
+/*
+ *  A frame like the game draws: the status text, the turret, a dozen
+ *	5x5 objects and the shield. run_frame clears the whole buffer first
+ *	and run_frame_dirty only what the last frame drew, then both send the
+ *	screen to the LCD.
+ */
+static void draw_frame(uint8_t i) {
+	draw_string(3, 0, "Time: 01:23", FG_COLOUR);
+	draw_string(3, 8, "Score: 1234", FG_COLOUR);
+	draw_line(LCD_X / 2, LCD_Y - 1, LCD_X / 2 + i % 8, LCD_Y - 8, FG_COLOUR);
+
+	for ( uint8_t k = 0; k < 12; k++ ) {
+		uint8_t x = (k * 7 + i) % (LCD_X - 5);
+		uint8_t y = 16 + (k * 3 + i) % 16;
+
+		for ( uint8_t j = 0; j < 5; j++ ) {
+			draw_line(x, y + j, x + 4, y + j, FG_COLOUR);
+		}
+	}
+
+	draw_line(0, 39, LCD_X - 1, 39, FG_COLOUR);
+}
+
+static void run_frame(uint8_t i) {
+	clear_screen();
+	draw_frame(i);
+	show_screen();
+}
+
+static void run_frame_dirty(uint8_t i) {
+	clear_dirty();
+	draw_frame(i);
+	show_screen();
+}
+
+static const char name_draw_pixel[] PROGMEM = "draw_pixel";
+static const char name_draw_line[] PROGMEM = "draw_line";
+static const char name_draw_char[] PROGMEM = "draw_char";
+static const char name_draw_string[] PROGMEM = "draw_string";
+static const char name_clear_screen[] PROGMEM = "clear_screen";
+static const char name_show_screen[] PROGMEM = "show_screen";
+static const char name_lcd_write[] PROGMEM = "lcd_write";
+static const char name_fill_rect[] PROGMEM = "fill_rect";
+static const char name_xor_blit[] PROGMEM = "xor_blit";
+static const char name_invert_screen[] PROGMEM = "invert_screen";
+static const char name_clear_dirty[] PROGMEM = "clear_dirty";
+static const char name_frame[] PROGMEM = "frame";
+static const char name_frame_dirty[] PROGMEM = "frame_dirty";
+
+static const benchmark_t benchmarks[] = {
+	{ name_draw_pixel, run_draw_pixel },
+	{ name_draw_line, run_draw_line },
+	{ name_draw_char, run_draw_char },
+	{ name_draw_string, run_draw_string },
+	{ name_clear_screen, run_clear_screen },
+	{ name_show_screen, run_show_screen },
+	{ name_lcd_write, run_lcd_write },
+	{ name_fill_rect, run_fill_rect },
+	{ name_xor_blit, run_xor_blit },
+	{ name_invert_screen, run_invert_screen },
+	{ name_clear_dirty, run_clear_dirty },
+	{ name_frame, run_frame },
+	{ name_frame_dirty, run_frame_dirty },
+};
+
+#define BENCHMARK_COUNT (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+/*
+ *  Call a function BENCHMARK_CALLS times, timing each call.
+ */
+static void measure(void (*run)(uint8_t i), uint32_t overhead,
+		uint32_t *total, uint32_t *min, uint32_t *max) {
+	*total = 0;
+	*min = UINT32_MAX;
+	*max = 0;
+
+	for ( uint8_t i = 0; i < BENCHMARK_CALLS; i++ ) {
+		uint32_t start = read_cycles();
+		run(i);
+		uint32_t cycles = read_cycles() - start;
+
+		cycles = cycles > overhead ? cycles - overhead : 0;
+		*total += cycles;
+		if ( cycles < *min ) *min = cycles;
+		if ( cycles > *max ) *max = cycles;
+	}
+}
+
+int main(void) {
+	uint32_t total, min, max;
+
+	lcd_init(LCD_DEFAULT_CONTRAST);
+
+	// Timer 1 in normal mode at the CPU clock
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);
+	TIMSK1 = (1 << TOIE1);
+	sei();
+
+	measure(run_nothing, 0, &total, &min, &max);
+	uint32_t overhead = min;
+
+	console_puts_P(PSTR("{\n\"f_cpu\": "));
+	console_putu(F_CPU);
+	console_puts_P(PSTR(",\n\"calls\": "));
+	console_putu(BENCHMARK_CALLS);
+	console_puts_P(PSTR(",\n\"overhead\": "));
+	console_putu(overhead);
+	console_puts_P(PSTR(",\n\"results\": [\n"));
+
+	for ( uint8_t b = 0; b < BENCHMARK_COUNT; b++ ) {
+		measure(benchmarks[b].run, overhead, &total, &min, &max);
+
+		console_puts_P(PSTR("{\"name\": \""));
+		console_puts_P(benchmarks[b].name);
+		console_puts_P(PSTR("\", \"mean\": "));
+		console_putu(total / BENCHMARK_CALLS);
+		console_puts_P(PSTR(", \"min\": "));
+		console_putu(min);
+		console_puts_P(PSTR(", \"max\": "));
+		console_putu(max);
+		console_puts_P(b + 1 < BENCHMARK_COUNT ? PSTR("},\n") : PSTR("}\n"));
+	}
+
+	console_puts_P(PSTR("]\n}\n"));
+
+	// simavr stops when the CPU sleeps with interrupts off.
+	cli();
+	sleep_mode();
+
+	return 0;
+}
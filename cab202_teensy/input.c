@@ -0,0 +1,232 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	input.c
+ *
+ *	Debounced joystick and button input for the TeensyPewPew.
+ */
+#include <stddef.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+#include "input.h"
+#include "macros.h"
+
+/*
+ *  Debounce state, owned by the interrupt handlers.
+ */
+static volatile uint16_t millis;
+static volatile uint8_t stable;
+static uint8_t counts[INPUT_COUNT];
+static uint8_t edge_pending;
+static uint16_t edge_time[INPUT_COUNT];
+
+/*
+ *  Event queue. Only the timer interrupt writes queue_head and only the
+ *	main program writes queue_tail, so taking events off needs no lock.
+ */
+static input_event_t queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t queue_head;
+static volatile uint8_t queue_tail;
+static volatile uint8_t dropped;
+
+/*
+ *  Where the timer interrupt takes chars from, or NULL.
+ */
+static int16_t (* volatile char_source)(void);
+
+/*
+ *  Read the raw level of every input.
+ */
+static uint8_t read_inputs(void) {
+	return BIT_VALUE(PINB, 0) << INPUT_CENTRE
+		| BIT_VALUE(PINB, 1) << INPUT_LEFT
+		| BIT_VALUE(PINB, 7) << INPUT_DOWN
+		| BIT_VALUE(PIND, 0) << INPUT_RIGHT
+		| BIT_VALUE(PIND, 1) << INPUT_UP
+		| BIT_VALUE(PINF, 5) << INPUT_SW3
+		| BIT_VALUE(PINF, 6) << INPUT_SW2;
+}
+
+/*
+ *  Remember the current time for every input that has left its debounced
+ *	level and has not been stamped yet.
+ */
+static void stamp_edges(uint8_t raw) {
+	uint8_t changed = (raw ^ stable) & ~edge_pending;
+
+	for ( uint8_t i = 0; i < INPUT_COUNT; i++ ) {
+		if ( changed & (1 << i) ) {
+			edge_time[i] = millis;
+		}
+	}
+
+	edge_pending |= changed;
+}
+
+/*
+ *  Add an event to the queue, or count it as dropped if the queue is full.
+ */
+static void post_event(uint8_t type, uint8_t code, uint16_t time) {
+	uint8_t next = (queue_head + 1) & (INPUT_QUEUE_SIZE - 1);
+
+	if ( next == queue_tail ) {
+		if ( dropped < 255 ) {
+			dropped++;
+		}
+		return;
+	}
+
+	queue[queue_head].type = type;
+	queue[queue_head].code = code;
+	queue[queue_head].time = time;
+	queue_head = next;
+}
+
+/*
+ *  Get the number of events that can be added before the queue is full.
+ */
+static uint8_t queue_room(void) {
+	return INPUT_QUEUE_SIZE - 1 - ((queue_head - queue_tail) & (INPUT_QUEUE_SIZE - 1));
+}
+
+/*
+ *  Queue the chars waiting in the char source, leaving INPUT_CHAR_RESERVE
+ *	slots for presses and releases.
+ */
+static void take_chars(void) {
+	int16_t (*source)(void) = char_source;
+
+	if ( source == NULL ) {
+		return;
+	}
+
+	while ( queue_room() > INPUT_CHAR_RESERVE ) {
+		int16_t c = source();
+
+		if ( c < 0 ) {
+			break;
+		}
+
+		post_event(INPUT_CHAR, c, millis);
+	}
+}
+
+/*
+ *  Edges on joystick centre, left and down (PORTB).
+ */
+ISR(PCINT0_vect) {
+	stamp_edges(read_inputs());
+}
+
+/*
+ *  Edges on joystick right (PD0).
+ */
+ISR(INT0_vect) {
+	stamp_edges(read_inputs());
+}
+
+/*
+ *  Edges on joystick up (PD1).
+ */
+ISR(INT1_vect) {
+	stamp_edges(read_inputs());
+}
+
+/*
+ *  Every millisecond: sample all inputs and accept the ones that have held
+ *	a new level for INPUT_DEBOUNCE_MS samples, then take the chars that
+ *	have arrived. The buttons on PORTF have no edge interrupt, so they are
+ *	stamped here.
+ */
+ISR(TIMER3_COMPA_vect) {
+	uint8_t raw = read_inputs();
+
+	millis++;
+	stamp_edges(raw);
+
+	for ( uint8_t i = 0; i < INPUT_COUNT; i++ ) {
+		uint8_t bit = 1 << i;
+
+		if ( (raw ^ stable) & bit ) {
+			if ( ++counts[i] >= INPUT_DEBOUNCE_MS ) {
+				stable ^= bit;
+				counts[i] = 0;
+				edge_pending &= ~bit;
+				post_event((stable & bit) ? INPUT_PRESS : INPUT_RELEASE, i, edge_time[i]);
+			}
+		}
+		else {
+			// Bounced back before it settled.
+			counts[i] = 0;
+			edge_pending &= ~bit;
+		}
+	}
+
+	take_chars();
+}
+
+void input_init(void) {
+	// Joystick
+	CLEAR_BIT(DDRB, 0);
+	CLEAR_BIT(DDRB, 1);
+	CLEAR_BIT(DDRB, 7);
+	CLEAR_BIT(DDRD, 0);
+	CLEAR_BIT(DDRD, 1);
+
+	// Buttons
+	CLEAR_BIT(DDRF, 5);
+	CLEAR_BIT(DDRF, 6);
+
+	stable = read_inputs();
+
+	// Pin change interrupts on PB0, PB1 and PB7
+	PCMSK0 = (1 << PCINT0) | (1 << PCINT1) | (1 << PCINT7);
+	PCICR |= (1 << PCIE0);
+
+	// Interrupt on any edge of INT0 (PD0) and INT1 (PD1)
+	EICRA = (EICRA & 0xF0) | (1 << ISC00) | (1 << ISC10);
+	EIMSK |= (1 << INT0) | (1 << INT1);
+
+	// Timer 3 in CTC mode, prescaler 8, compare match every millisecond
+	TCCR3A = 0;
+	TCCR3B = (1 << WGM32) | (1 << CS31);
+	OCR3A = F_CPU / 8 / 1000 - 1;
+	TIMSK3 = (1 << OCIE3A);
+}
+
+uint8_t input_state(void) {
+	return stable;
+}
+
+bool input_next_event(input_event_t *event) {
+	uint8_t tail = queue_tail;
+
+	if ( tail == queue_head ) {
+		return false;
+	}
+
+	*event = queue[tail];
+	queue_tail = (tail + 1) & (INPUT_QUEUE_SIZE - 1);
+	return true;
+}
+
+void input_set_char_source(int16_t (*source)(void)) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		char_source = source;
+	}
+}
+
+uint8_t input_dropped(void) {
+	return dropped;
+}
+
+uint16_t input_millis(void) {
+	uint16_t time;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		time = millis;
+	}
+
+	return time;
+}
@@ -0,0 +1,122 @@
+/*
+ *  CAB202 Teensy Library (cab202_teensy)
+ *	input.h
+ *
+ *	Debounced joystick and button input for the TeensyPewPew.
+ *
+ *	Edges on the joystick are caught by pin change (PORTB) and external
+ *	(PORTD) interrupts. A 1 ms timer interrupt debounces every input and
+ *	queues a press or release event once an input has been stable for
+ *	INPUT_DEBOUNCE_MS, stamped with the time of its first edge. Presses
+ *	are therefore never lost, however long the main loop takes.
+ *
+ *	The same interrupt takes chars from a source set with
+ *	input_set_char_source (e.g. USB serial) and queues them, stamped with
+ *	the millisecond they were taken, so everything the program reacts to
+ *	is taken off one queue in one place.
+ *
+ *	The timer interrupt is the only producer. In each millisecond it
+ *	queues presses and releases first and chars after them, so the queue
+ *	holds events in the order they happened to within a millisecond.
+ */
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *  Inputs of the TeensyPewPew. The value of each is also its bit in
+ *	input_state().
+ */
+typedef enum input_t {
+	INPUT_CENTRE = 0,	// joystick centre, PB0
+	INPUT_LEFT = 1,		// joystick left, PB1
+	INPUT_DOWN = 2,		// joystick down, PB7
+	INPUT_RIGHT = 3,	// joystick right, PD0
+	INPUT_UP = 4,		// joystick up, PD1
+	INPUT_SW3 = 5,		// right button, PF5
+	INPUT_SW2 = 6,		// left button, PF6
+} input_t;
+
+#define INPUT_COUNT 7
+
+/*
+ *  Number of consecutive 1 ms samples an input must hold a new level
+ *	before the change is accepted.
+ */
+#define INPUT_DEBOUNCE_MS 5
+
+/*
+ *  Number of events the queue holds. Must be a power of 2.
+ */
+#define INPUT_QUEUE_SIZE 16
+
+/*
+ *  Number of queue slots the char source leaves free for presses and
+ *	releases. Chars that do not fit wait in the source.
+ */
+#define INPUT_CHAR_RESERVE 4
+
+/*
+ *  Kinds of event in the queue.
+ */
+typedef enum input_event_type_t {
+	INPUT_PRESS = 0,	// code is the input_t pressed
+	INPUT_RELEASE = 1,	// code is the input_t released
+	INPUT_CHAR = 2,		// code is a char taken from the char source
+} input_event_type_t;
+
+/*
+ *  One event in the queue.
+ */
+typedef struct input_event_t {
+	uint8_t type;		// an input_event_type_t
+	uint8_t code;		// the input or char
+	uint16_t time;		// input_millis() at the first edge, or when taken
+} input_event_t;
+
+/*
+ *  Set up the input pins, the edge interrupts and the 1 ms debounce timer
+ *	(timer 3). Interrupts must be enabled for input to be seen.
+ */
+void input_init(void);
+
+/*
+ *  Get the debounced level of every input, bit n set if input n is held.
+ */
+uint8_t input_state(void);
+
+/*
+ *  Take the oldest event off the queue.
+ *
+ *	Parameters:
+ *		event - Where the event is stored.
+ *
+ *	Returns true if there was an event, false if the queue was empty.
+ */
+bool input_next_event(input_event_t *event);
+
+/*
+ *  Set where the timer interrupt takes chars from. Every millisecond it
+ *	takes chars until the source returns a negative value or only
+ *	INPUT_CHAR_RESERVE slots of the queue are left. The source is called
+ *	with interrupts off, so it must be safe to call from an interrupt.
+ *
+ *	Parameters:
+ *		source - Returns the next char, or -1 if there is none. NULL stops
+ *			taking chars.
+ */
+void input_set_char_source(int16_t (*source)(void));
+
+/*
+ *  Get the number of events lost because the queue was full.
+ */
+uint8_t input_dropped(void);
+
+/*
+ *  Get the milliseconds counted by the debounce timer. Wraps every 65.5 s.
+ */
+uint16_t input_millis(void);
+
+#endif /* INPUT_H_ */
@@ -7,17 +7,70 @@
  */
 #include "ram_utils.h"
 
+extern uint8_t __data_start, __data_end, __bss_start, __bss_end;
+extern uint8_t __heap_start, _end;
+extern char *__brkval;
+
+/*
+ * Paint everything between the end of .bss and the top of RAM with
+ * RAM_CANARY. It runs from .init3, after the stack pointer is set up and
+ * before .data and .bss are, so nothing is in use yet. It is naked and
+ * must not call anything, as there is no stack frame to return through.
+ */
+void ram_paint_stack(void) __attribute__ ((naked, used, section(".init3")));
+
+void ram_paint_stack(void){
+	uint8_t *p = &_end;
+
+	while ( p <= (uint8_t *) RAMEND ) {
+		*p++ = RAM_CANARY;
+	}
+}
+
+/* lowest byte of free RAM not used by the heap */
+static uint8_t* heap_top(void){
+	return __brkval == 0 ? &__heap_start : (uint8_t *) __brkval;
+}
+
+/* lowest byte the stack has ever written */
+static uint8_t* stack_low_water(void){
+	uint8_t *p = heap_top();
+
+	while ( p <= (uint8_t *) RAMEND && *p == RAM_CANARY )
+		p++;
+
+	return p;
+}
+
+uint16_t ram_data_size(void){
+	return &__data_end - &__data_start;
+}
+
+uint16_t ram_bss_size(void){
+	return &__bss_end - &__bss_start;
+}
+
+uint16_t ram_heap_size(void){
+	return heap_top() - &__heap_start;
+}
+
+uint16_t ram_stack_peak(void){
+	return (uint8_t *) RAMEND + 1 - stack_low_water();
+}
+
+uint16_t ram_stack_unused(void){
+	return stack_low_water() - heap_top();
+}
+
 #if WANT_ESTIMATE_ALLOC
 int estimate_alloc(int len){
-	extern int __heap_start, *__brkval;
-	int v;
-	return (int) (&v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval) - len);
+	uint8_t v;
+	return (int) (&v - heap_top()) - len;
 }
 
 int estimate_ram(void){
-  extern int __heap_start, *__brkval;
-  int v;
-  return (int) (&v - (__brkval == 0 ? (int) &__heap_start : (int) __brkval));
+	uint8_t v;
+	return (int) (&v - heap_top());
 }
 #endif
 
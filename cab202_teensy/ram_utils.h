@@ -14,6 +14,12 @@
 
 #define RAM_GUARD 100
 
+/*
+ * Value painted over the free RAM at boot, so the deepest the stack has
+ * reached can be found by looking for the first byte that has changed.
+ */
+#define RAM_CANARY 0xC5
+
 /*
  * RAM debugging functions
  */
@@ -21,6 +27,16 @@
 int estimate_alloc(int len);
 int estimate_ram(void);
 #endif
+
+/*
+ * RAM budget, all sizes in bytes
+ */
+uint16_t ram_data_size(void);
+uint16_t ram_bss_size(void);
+uint16_t ram_heap_size(void);
+uint16_t ram_stack_peak(void);
+uint16_t ram_stack_unused(void);
+
 unsigned char* load_rom_bitmap(const unsigned char* source, int len);
 unsigned char* load_rom_string(const unsigned char* source);
 
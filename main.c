@@ -2,19 +2,31 @@
 #include <stdio.h>
 #include <avr/io.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
 #include <lcd.h>
 #include <string.h>
 #include <util/delay.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
 #include <cpu_speed.h>
 #include <graphics.h>
 #include <macros.h>
+#include <input.h>
+#include <ram_utils.h>
+#include <format.h>
+#include <backlight.h>
 #include "cab202_adc.h"
 #include <usb_serial.h>
 #include "lcd_model.h"
 #include <math.h>
 #include "main.h"
+#include "waves.h"
+#include "asteroid_frames.h"
 
 ///===============================================================
 //                         Objects
@@ -26,81 +38,173 @@ struct SpaceShip{
 struct Object{
     double x, y, angle;
 };
+// everything the game samples from outside in one frame
+struct FrameInput{
+    uint8_t buttons;    // held or pressed during the frame
+    uint8_t pressed;    // pressed since the last frame
+    uint8_t received_count;
+    char received[FRAME_CHARS]; // chars received since the last frame
+    uint16_t left_adc, right_adc;
+    uint32_t ticks;
+};
+
+// what the main loop runs each frame, see Scenes
+enum Scene{
+    SCENE_INTRO,
+    SCENE_PLAYING,
+    SCENE_STATUS,       // paused on the status screen
+    SCENE_GAME_OVER,
+    SCENE_QUIT
+};
+
+// a dash moving across the intro screen
+struct Animation{
+    int x, y, angle;
+};
+
+// one pixel of an explosion, position and velocity in 1/16 pixels
+struct Particle{
+    int16_t x, y;
+    int8_t dx, dy;
+    uint8_t life;       // frames left
+};
+
+// object lists and everything else one game needs, ordered so the small
+// fields used every frame sit together ahead of the object lists
+struct GameState{
+    // setup values
+    bool isPasued;
+    bool isFirstStart;
+    bool generated;
+    bool warned;
+    bool isSpace;
+    bool speedIsSet;
+    bool isNegative;
+    int LED_side;
+    uint32_t led_ticks;
+    // game informations to display
+    int score;
+    int shield_life;
+    // game counters
+    int plasma_counter;
+    int asteroid_counter;
+    int boulder_counter;
+    int fragment_counter;
+    int leftcounter, rightcounter;
+    // waves
+    struct Wave wave_info;
+    uint8_t wave;
+    uint8_t spawn_pending;
+    uint8_t spawn_timer;
+    uint8_t wave_dropped;
+    // asteroid rotation, the frame of each asteroid kept beside the list
+    // so objects stay three doubles
+    uint8_t spin_step;
+    uint8_t asteroid_frame[MAX_ASTEROID];
+    // cheat commands
+    int cheat_x, cheat_y;
+    int ship_angle;
+    char list[5];
+    int converted_number;
+    int char_counter;
+    int16_t char_code;
+    char input;
+    char char_buffer;
+    char ingame_buffer;
+    // timers
+    double m_timer;
+    double o_timer;
+    double plasma_timer;
+    double time;
+    double speed;
+    double leftpotent;
+    double rightpotent;
+    double cx, cy;
+    // inputs of the current frame
+    struct FrameInput frame_input;
+    struct SpaceShip ship;
+    // object lists
+    struct Object plasma_list[MAX_PLASMA];
+    struct Object asteroid_list[MAX_ASTEROID];
+    struct Object boulder_list[MAX_BOULDER];
+    struct Object fragment_list[MAX_FRAGMENT];
+};
+
+// a group of asteroids must fit the list and the screen
+_Static_assert(MAX_ASTEROID >= SPAWN_GROUP_MAX, "MAX_ASTEROID must hold a group");
+_Static_assert(7 * SPAWN_GROUP_MAX < LCD_X, "a group must fit across the screen");
+// load_game reads the list counters of a snapshot as one array
+_Static_assert(offsetof(struct GameState, fragment_counter) == offsetof(struct GameState, plasma_counter) + 3 * sizeof(int),
+               "the list counters must sit together in plasma, asteroid, boulder, fragment order");
 
-// initialisition of objects
-struct SpaceShip ship = {38, 46};
+// the only game on the teensy
+static struct GameState game_state;
 
-// object lists
-struct Object plasma_list[MAX_PLASMA];
-struct Object asteroid_list[MAX_ASTEROID];
-struct Object boulder_list[MAX_BOULDER];
-struct Object fragment_list[MAX_FRAGMENT];
 ///===============================================================
 //                     Variables
 ///===============================================================
 
 volatile uint32_t overflow_counter = 0;
-double leftpotent;
-double rightpotent;
-// game informations to display
-int score = 0;
-int shield_life = SHIELD_LIFE;
-// game counters
-int plasma_counter = 0;
-int asteroid_counter = 0;
-int boulder_counter = 0;
-int fragment_counter = 0;
-
-//
-double cx = 40, cy = 40;
-bool speedIsSet;
-bool isFirstStart = true;
-double m_timer = -1;
-double o_timer = -1;
-bool isNegative;
-double plasma_timer = 0;
-double time = 0;
-double speed = 1;
-
-int leftcounter = 0, rightcounter = 0;
-int cheat_x = -1, cheat_y = -1;
-int ship_angle;
-char list[5];
-int converted_number = 0;
-int char_counter = 0;
-int16_t char_code = 32;
-char input;
-char char_buffer;
-char ingame_buffer;
-//test
-
-// setup values
-bool isPasued = true;
-bool generated = false;
-bool warned = false;
-bool isSpace = false;
-int LED_side;
+
+// input recorder
+bool isRecording = false;
+bool isReplaying = false;
+bool isSessionPending = false;
+uint16_t session_seed;
+bool isStateRequested = false;
+
+// input latency measurement
+bool isMeasuring = false;
+uint16_t latency_pending[LATENCY_PENDING];
+uint8_t latency_pending_count = 0;
+uint16_t latency_histogram[LATENCY_BUCKETS];
+uint16_t latency_samples = 0;
+uint16_t latency_max = 0;
+
+// scenes, the frame and timer0 tick each began at and what they animate
+enum Scene scene = SCENE_INTRO;
+uint8_t scene_phase = 0;
+uint32_t scene_ticks = 0;
+struct Animation intro_dashes[2];
+
+// explosion particles, drawn over the game and not part of its state,
+// and the direction the next explosion starts from
+struct Particle particle_pool[MAX_PARTICLE];
+uint8_t particle_counter = 0;
+uint8_t particle_budget = PARTICLE_BUDGET;
+uint8_t particle_turn = 0;
+
+#if COLLISION_BITMAP
+// the owner id of the target in each 1x8 strip of the screen, laid out
+// like screen_buffer, see occupy_objects
+uint8_t occupancy[LCD_BUFFER_SIZE];
+#define OCCUPANCY_RAM sizeof(occupancy)
+#else
+#define OCCUPANCY_RAM 0
+#endif
+
+#ifdef __AVR__
+// the big variables of the game must leave STACK_RESERVE bytes of RAM, on
+// the teensy where a double is 4 bytes. the object lists of the intense
+// capacity profile do not leave room for the collision bitmap
+_Static_assert(sizeof(game_state) + OCCUPANCY_RAM + sizeof(particle_pool) + sizeof(screen_buffer)
+               + sizeof(latency_pending) + sizeof(latency_histogram) <= RAM_SIZE - STACK_RESERVE,
+               "the game does not leave STACK_RESERVE bytes of RAM");
+#endif
 
 
 ///===============================================================
 //                            Shapes
 ///===============================================================
-char * spaceship =
+const char spaceship[] PROGMEM =
 "......"
 "......"
 ;
 
-char * asteroid =
-"  ...  "
-" ..... "
-"......."
-"......."
-" ..... "
-"  ...  "
-"   .   "
-;
+// the asteroid is drawn from its rotation frames in asteroid_frames.h,
+// built from the shape in tools/rotate_sprites.c
 
-char * boulder =
+const char boulder[] PROGMEM =
 "  .  "
 " ... "
 "....."
@@ -108,18 +212,18 @@ char * boulder =
 "  .  "
 ;
 
-char * fragment =
+const char fragment[] PROGMEM =
 " . "
 "..."
 " . "
 ;
 
-char * plasma =
+const char plasma[] PROGMEM =
 ".."
 ".."
 ;
 
-char * animation =
+const char animation[] PROGMEM =
 "....."
 ;
 
@@ -127,7 +231,7 @@ char * animation =
  *  Timer overflow
  */
 ISR(TIMER0_OVF_vect) {
-    if (!isPasued) {
+    if (!game_state.isPasued) {
         overflow_counter++;
     }
 }
@@ -135,6 +239,57 @@ ISR(TIMER0_OVF_vect) {
 //                       Help Functions
 ///===============================================================
 
+// sine of 0 to 90 degrees, all angles in the game are whole degrees
+const float sine_table[91] PROGMEM = {
+    0.0000000, 0.0174524, 0.0348995, 0.0523360, 0.0697565, 0.0871557,
+    0.1045285, 0.1218693, 0.1391731, 0.1564345, 0.1736482, 0.1908090,
+    0.2079117, 0.2249511, 0.2419219, 0.2588190, 0.2756374, 0.2923717,
+    0.3090170, 0.3255682, 0.3420201, 0.3583679, 0.3746066, 0.3907311,
+    0.4067366, 0.4226183, 0.4383711, 0.4539905, 0.4694716, 0.4848096,
+    0.5000000, 0.5150381, 0.5299193, 0.5446390, 0.5591929, 0.5735764,
+    0.5877853, 0.6018150, 0.6156615, 0.6293204, 0.6427876, 0.6560590,
+    0.6691306, 0.6819984, 0.6946584, 0.7071068, 0.7193398, 0.7313537,
+    0.7431448, 0.7547096, 0.7660444, 0.7771460, 0.7880108, 0.7986355,
+    0.8090170, 0.8191520, 0.8290376, 0.8386706, 0.8480481, 0.8571673,
+    0.8660254, 0.8746197, 0.8829476, 0.8910065, 0.8987940, 0.9063078,
+    0.9135455, 0.9205049, 0.9271839, 0.9335804, 0.9396926, 0.9455186,
+    0.9510565, 0.9563048, 0.9612617, 0.9659258, 0.9702957, 0.9743701,
+    0.9781476, 0.9816272, 0.9848078, 0.9876883, 0.9902681, 0.9925462,
+    0.9945219, 0.9961947, 0.9975641, 0.9986295, 0.9993908, 0.9998477,
+    1.0000000
+};
+
+/**
+ *  return: the sine of the angle, without calling sin()
+ *
+ *  Parameters:
+ *      angle: an angle in whole degrees
+ */
+double sin_deg(int angle){
+    angle %= 360;
+    if (angle < 0) {
+        angle += 360;
+    }
+    if (angle <= 90) {
+        return pgm_read_float(&sine_table[angle]);
+    }else if (angle <= 180){
+        return pgm_read_float(&sine_table[180 - angle]);
+    }else if (angle <= 270){
+        return -pgm_read_float(&sine_table[angle - 180]);
+    }
+    return -pgm_read_float(&sine_table[360 - angle]);
+}
+
+/**
+ *  return: the cosine of the angle, without calling cos()
+ *
+ *  Parameters:
+ *      angle: an angle in whole degrees
+ */
+double cos_deg(int angle){
+    return sin_deg(angle + 90);
+}
+
 /**
  *  Prepare all the bits for future usages
  */
@@ -146,57 +301,39 @@ void setup_bit(){
     TIMSK0 = 1;
     sei();
     
-    //Joysticks
-    CLEAR_BIT(DDRD, 1);
-    CLEAR_BIT(DDRB, 7);
-    CLEAR_BIT(DDRB, 1);
-    CLEAR_BIT(DDRD, 0);
-    CLEAR_BIT(DDRB, 0);
-    
-    //Buttons
-    CLEAR_BIT(DDRF, 6);
-    CLEAR_BIT(DDRF, 5);
+    //Joysticks and buttons, debounced in the background
+    input_init();
     
     //LED
     SET_BIT(DDRB, 2);
     SET_BIT(DDRB, 3);
     
-    //Potentiometer
+    //Potentiometer, sampled in the background
     adc_init();
+    adc_start_sampling(BIT(0) | BIT(1));
     
     //LCD Screen
     lcd_init(LCD_DEFAULT_CONTRAST);
     
-    //USB
+    //USB, chars received are queued with the inputs in the background
     usb_init();
+    input_set_char_source(usb_serial_getchar);
     
+    //LCD backlight, faded in the background
+    backlight_init();
     
-    TC4H = OVERFLOW_TOP >> 8;
-    OCR4C = OVERFLOW_TOP & 0xff;
-    
-    // Enable PWM
-    TCCR4A = BIT(COM4A1) | BIT(PWM4A);
-    // Bit set for the LCD backlight
-    SET_BIT(DDRC, 7);
-    TCCR4B = BIT(CS42) | BIT(CS41) | BIT(CS40);
-    TCCR4D = 0;
     // wait until usb is configured
     while (!usb_configured()){};
 }
 
 /**
- *  Send a string to computer
- */
-void usb_serial_send(char * message) {
-    usb_serial_write((uint8_t *) message, strlen(message));
-}
-
-/**
- *  Set the background light of lcd screen
+ *  Send a string stored in flash to computer
  */
-void set_duty_cycle(int duty_cycle) {
-    TC4H = duty_cycle >> 8;
-    OCR4A = duty_cycle & 0xff;
+void usb_serial_send_P(const char * message) {
+    char c;
+    while ((c = pgm_read_byte(message++)) != 0) {
+        usb_serial_putchar(c);
+    }
 }
 
 /**
@@ -214,11 +351,11 @@ void set_duty_cycle(int duty_cycle) {
  *      h1: An integer which is the height of the given shape
  *      pixels1: formatted shape
  */
-bool pixel_collision(int x0, int y0, int w0, int h0, char pixels0[], int x1, int y1, int w1, int h1, char pixels1[]){
+bool pixel_collision(int x0, int y0, int w0, int h0, const char pixels0[], int x1, int y1, int w1, int h1, const char pixels1[]){
     for (int j=y0; j<y0+h0; j++){
         for(int i=x0; i<x0+w0; i++){
-            if (i >= x1 && i < x1 + w1 && j >= y1 && j < y1 + h1 && pixels0[(i - x0) + (j - y0)*w0] != ' ' ){
-                if (i >= x0 && i < x0 + w0 && j >= y0 && j < y0 + h0 && pixels1[(i - x1) + (j - y1)*w1] != ' '){
+            if (i >= x1 && i < x1 + w1 && j >= y1 && j < y1 + h1 && pgm_read_byte(&pixels0[(i - x0) + (j - y0)*w0]) != ' ' ){
+                if (i >= x0 && i < x0 + w0 && j >= y0 && j < y0 + h0 && pgm_read_byte(&pixels1[(i - x1) + (j - y1)*w1]) != ' '){
                     return true;
                 }
             }
@@ -230,32 +367,60 @@ bool pixel_collision(int x0, int y0, int w0, int h0, char pixels0[], int x1, int
 /**
  *  Draws formatted shape base on string
  */
-void draw_pixels(int left, int top, int width, int height, char bitmap[]){
+void draw_pixels(int left, int top, int width, int height, const char bitmap[]){
     for (int j=0; j<height; j++){
         for(int i=0; i<width; i++){
-            if (bitmap[i + j * width] != ' '){
+            if (pgm_read_byte(&bitmap[i + j * width]) != ' '){
                 draw_pixel(left + i, top + j, FG_COLOUR);
             }
         }
     }
 }
 
-char buffer[20];
-
 /**
- *  Draws a double value on teensy screen
- */
-void draw_double(uint8_t x, uint8_t y, double value, colour_t colour) {
-    snprintf(buffer, sizeof(buffer), "%f", value);
-    draw_string(x, y, buffer, colour);
+ *  draw a packed shape, one byte a row with bit n set for a pixel in
+ *  column n
+ *  Parameters:
+ *      left: x coordinate of the shape
+ *      top: y coordinate of the shape
+ *      height: height of the shape
+ *      mask: packed shape
+ */
+void draw_mask(int left, int top, int height, const uint8_t mask[]){
+    for (int j = 0; j < height; j++) {
+        uint8_t row = pgm_read_byte(&mask[j]);
+        for (int i = 0; row != 0; i++, row >>= 1) {
+            if (row & 1) {
+                draw_pixel(left + i, top + j, FG_COLOUR);
+            }
+        }
+    }
 }
 
 /**
- *  Draws a int value on teensy screen
- */
-void draw_int(uint8_t x, uint8_t y, int value, colour_t colour) {
-    snprintf(buffer, sizeof(buffer), "%d", value);
-    draw_string(x, y, buffer, colour);
+ *  return: if a plasma at the given position covers a pixel of a packed
+ *  shape
+ *  Parameters:
+ *      x: x coordinate of the shape
+ *      y: y coordinate of the shape
+ *      height: height of the shape
+ *      mask: packed shape
+ *      px: x coordinate of the plasma
+ *      py: y coordinate of the plasma
+ */
+bool mask_collision(int x, int y, int height, const uint8_t mask[], int px, int py){
+    for (int j = py; j < py + 2; j++) {
+        if (j < y || j >= y + height) {
+            continue;
+        }
+        uint8_t row = pgm_read_byte(&mask[j - y]);
+        for (int i = px; i < px + 2; i++) {
+            if (i >= x && i < x + 8 && (row & BIT(i - x))) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 /**
@@ -277,22 +442,383 @@ bool accept_char(char c){
  */
 bool ingame_char(char c){
     return (c == 'a' || c == 'd' || c == 'w' || c == 's' || c == 'r' ||
-            c == 'p' || c == 'q' || c == '?');
+            c == 'p' || c == 'q' || c == '?' || c == 'v' || c == 'y' ||
+            c == 'x' || c == 'b' || c == 'n' || c == 'u' || c == 'z' ||
+            c == 'c' || c == 'e');
 }
 
 /**
  *  update the time if the game is not paused
  */
-void update_time(){
-    if (!isPasued) {
-        time = ( overflow_counter * 256.0 + TCNT0 ) * PRESCALE  / FREQ;
+void update_time(struct GameState * game){
+    if (!game->isPasued) {
+        game->time = game->frame_input.ticks * PRESCALE  / FREQ;
+    }
+}
+
+/**
+ *  return: the timer0 ticks counted since the game was started
+ */
+uint32_t read_ticks(){
+    uint32_t ticks;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ticks = overflow_counter * 256 + TCNT0;
+    }
+    return ticks;
+}
+
+///===============================================================
+//                     Latency measurement
+///===============================================================
+
+/**
+ *  remember when an input used in this frame happened, its latency is
+ *  counted once the frame is on the screen
+ *  Parameters:
+ *      time: input_millis() when the input happened
+ */
+void note_latency(uint16_t time){
+    if (isMeasuring && !isReplaying && latency_pending_count < LATENCY_PENDING) {
+        latency_pending[latency_pending_count++] = time;
+    }
+}
+
+/**
+ *  count the latency of every input used in this frame, called once the
+ *  frame is on the screen
+ */
+void count_latency(){
+    uint16_t now = input_millis();
+    for (uint8_t a = 0; a < latency_pending_count; a++) {
+        uint16_t latency = now - latency_pending[a];
+        uint8_t bucket = LATENCY_BUCKETS - 1;
+        if (latency / LATENCY_BUCKET_MS < LATENCY_BUCKETS - 1) {
+            bucket = latency / LATENCY_BUCKET_MS;
+        }
+        if (latency_samples < UINT16_MAX) {
+            latency_histogram[bucket]++;
+            latency_samples++;
+        }
+        if (latency > latency_max) {
+            latency_max = latency;
+        }
+    }
+    latency_pending_count = 0;
+}
+
+/**
+ *  show the frame on teensy screen and count the latency of every input
+ *  that was used in it
+ */
+void show_frame(){
+    show_screen();
+    count_latency();
+}
+
+///===============================================================
+//                       Input sampling
+///===============================================================
+
+/**
+ *  read the joystick, buttons, serial, pots and timer into frame_input
+ *
+ *  The input queue holds the presses and the chars from computer in the
+ *  order they happened, every one of them is taken here. Once FRAME_CHARS
+ *  chars are taken the rest stay queued for the next frame.
+ */
+void read_hardware_inputs(struct GameState * game){
+    input_event_t event;
+    game->frame_input.pressed = 0;
+    game->frame_input.buttons = 0;
+    game->frame_input.received_count = 0;
+    while (game->frame_input.received_count < FRAME_CHARS && input_next_event(&event)) {
+        switch (event.type) {
+            case INPUT_PRESS:
+                // a press shorter than a frame still counts
+                SET_BIT(game->frame_input.pressed, event.code);
+                note_latency(event.time);
+                break;
+            case INPUT_CHAR:
+                game->frame_input.received[game->frame_input.received_count++] = event.code;
+                note_latency(event.time);
+                break;
+        }
+    }
+    game->frame_input.buttons |= input_state() | game->frame_input.pressed;
+    game->frame_input.left_adc = adc_latest(0);
+    game->frame_input.right_adc = adc_latest(1);
+    game->frame_input.ticks = read_ticks();
+}
+
+/**
+ *  send bytes to computer as hexadecimal digits
+ */
+void usb_serial_send_hex(uint8_t * data, uint16_t length){
+    static const char hex_digits[] PROGMEM = "0123456789ABCDEF";
+    for (uint16_t a = 0; a < length; a++) {
+        usb_serial_putchar(pgm_read_byte(&hex_digits[data[a] >> 4]));
+        usb_serial_putchar(pgm_read_byte(&hex_digits[data[a] & 0x0F]));
+    }
+}
+
+/**
+ *  return: the next char from computer, waiting until one arrives. chars
+ *  come through the input queue, presses met on the way are thrown away
+ */
+char usb_serial_wait_char(){
+    input_event_t event;
+    do {
+        // idle until an interrupt queues something
+        while (!input_next_event(&event)) {
+            sleep_mode();
+        }
+    } while (event.type != INPUT_CHAR);
+    return event.code;
+}
+
+/**
+ *  read bytes sent by computer as hexadecimal digits
+ */
+void usb_serial_read_hex(uint8_t * data, uint16_t length){
+    for (uint16_t a = 0; a < length; a++) {
+        uint8_t value = 0;
+        for (uint8_t b = 0; b < 2; b++) {
+            char c = usb_serial_wait_char();
+            value <<= 4;
+            if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            }else if (c >= 'a' && c <= 'f'){
+                value |= c - 'a' + 10;
+            }else{
+                value |= (c - '0') & 0x0F;
+            }
+        }
+        data[a] = value;
+    }
+}
+
+/**
+ *  load the inputs of the next recorded frame, the replay ends on "#E"
+ */
+void replay_frame_input(struct GameState * game){
+    // presses made during the replay are not part of it, waiting for the
+    // chars throws them away so they do not all fire when it ends
+    while (usb_serial_wait_char() != '#') {}
+    if (usb_serial_wait_char() == 'F') {
+        usb_serial_read_hex((uint8_t *) &game->frame_input, sizeof(game->frame_input));
+    }else{
+        isReplaying = false;
+        // tell the computer the replay is over, see tools/replay_check.c
+        usb_serial_send_P(PSTR("#E\r\n"));
+        read_hardware_inputs(game);
+    }
+}
+
+/**
+ *  sample the inputs of this frame, from the hardware or from a replay,
+ *  and send them to computer while recording
+ */
+void sample_inputs(struct GameState * game){
+    if (isReplaying) {
+        replay_frame_input(game);
+    }else{
+        read_hardware_inputs(game);
+    }
+    if (isRecording) {
+        usb_serial_send_P(PSTR("#F"));
+        usb_serial_send_hex((uint8_t *) &game->frame_input, sizeof(game->frame_input));
+        usb_serial_send_P(PSTR("\r\n"));
+    }
+}
+
+/**
+ *  return: weather the char was received from computer in this frame
+ *
+ *  Parameters:
+ *      game: the game
+ *      c: a char
+ */
+bool received_char(struct GameState * game, char c){
+    for (uint8_t a = 0; a < game->frame_input.received_count; a++) {
+        if (game->frame_input.received[a] == c) {
+            return true;
+        }
+    }
+    return false;
+}
+
+///===============================================================
+//                          Particles
+///===============================================================
+
+// 8 directions at 1 pixel a frame, in 1/16 pixels
+const int8_t particle_directions[8][2] PROGMEM = {
+    {16, 0}, {11, 11}, {0, 16}, {-11, 11},
+    {-16, 0}, {-11, -11}, {0, -16}, {11, -11},
+};
+
+/**
+ *  start an explosion, the particles fly out from the centre in turn
+ *  around the 8 directions, the second 8 at half speed. no more than
+ *  PARTICLE_BUDGET start in a frame and the rest are left out
+ *  Parameters:
+ *      x: x coordinate of the centre
+ *      y: y coordinate of the centre
+ *      count: number of particles
+ */
+void explode(int x, int y, uint8_t count){
+    particle_turn++;
+    for (uint8_t a = 0; a < count; a++) {
+        if (particle_budget == 0 || particle_counter >= MAX_PARTICLE) {
+            return;
+        }
+        particle_budget--;
+        uint8_t direction = (a + particle_turn) & 7;
+        uint8_t slow = (a >> 3) & 1;
+        struct Particle * particle = &particle_pool[particle_counter++];
+        particle->x = x * 16;
+        particle->y = y * 16;
+        particle->dx = (int8_t)pgm_read_byte(&particle_directions[direction][0]) >> slow;
+        particle->dy = (int8_t)pgm_read_byte(&particle_directions[direction][1]) >> slow;
+        particle->life = PARTICLE_LIFE - (a & 3);
+    }
+}
+
+/**
+ *  remove every particle and start the directions again, so a replay
+ *  draws the same explosions as the game it was recorded from
+ */
+void reset_particles(){
+    particle_counter = 0;
+    particle_budget = PARTICLE_BUDGET;
+    particle_turn = 0;
+}
+
+/**
+ *  move, age and draw every particle in one pass, writing straight into
+ *  screen_buffer, and drop the ones that die or leave the screen. the pool
+ *  is fixed, so this costs at most MAX_PARTICLE pixels a frame
+ *  Parameters:
+ *      game: the game
+ */
+void update_particles(struct GameState * game){
+    int left = LCD_X, top = LCD_Y, right = -1, bottom = -1;
+    uint8_t a = 0;
+    particle_budget = PARTICLE_BUDGET;
+    while (a < particle_counter) {
+        struct Particle * particle = &particle_pool[a];
+        if (!game->isPasued) {
+            particle->x += particle->dx;
+            particle->y += particle->dy;
+            particle->life--;
+        }
+        int x = particle->x >> 4;
+        int y = particle->y >> 4;
+        if (particle->life == 0 || x < 0 || x >= LCD_X || y < 0 || y >= LCD_Y) {
+            // the last particle takes its place
+            *particle = particle_pool[--particle_counter];
+            continue;
+        }
+        screen_buffer[(y >> 3) * LCD_X + x] |= 1 << (y & 7);
+        if (x < left) left = x;
+        if (x > right) right = x;
+        if (y < top) top = y;
+        if (y > bottom) bottom = y;
+        a++;
+    }
+    if (right >= 0) {
+        mark_drawn(left, top, right, bottom);
+    }
+}
+
+///===============================================================
+//                              HUD
+///===============================================================
+
+// a number on the status screen, formatted and drawn again only when it
+// changes
+struct HudField{
+    uint8_t x, y;
+    uint8_t width;      // least number of digits, padded with '0'
+    uint8_t drawn;      // chars drawn last time
+    int value;
+};
+
+enum HudFieldIndex{
+    HUD_MINUTES,
+    HUD_SECONDS,
+    HUD_LIFE,
+    HUD_SCORE,
+    HUD_FIELDS
+};
+
+struct HudField hud_fields[HUD_FIELDS] = {
+    [HUD_MINUTES] = {29, 7, 2},
+    [HUD_SECONDS] = {46, 7, 2},
+    [HUD_LIFE] = {32, 17, 1},
+    [HUD_SCORE] = {40, 27, 1},
+};
+
+// if the labels are on the screen and the fields hold what is drawn
+bool isHudDrawn = false;
+
+/**
+ *  draw a field again if its value changed or the status screen was just
+ *  drawn, clearing only the chars it drew last time
+ *  Parameters:
+ *      index: the field
+ *      value: its value now
+ *  return: if the field was drawn
+ */
+bool hud_set(enum HudFieldIndex index, int value){
+    struct HudField * field = &hud_fields[index];
+    if (isHudDrawn && field->value == value) {
+        return false;
+    }
+    char text[FORMAT_INT_SIZE];
+    fill_rect(field->x, field->y, field->drawn * CHAR_WIDTH, CHAR_HEIGHT, BG_COLOUR);
+    field->drawn = format_int(text, sizeof(text), value, field->width);
+    field->value = value;
+    draw_string(field->x, field->y, text, FG_COLOUR);
+    return true;
+}
+
+/**
+ *  forget what the status screen shows, so it is drawn whole next time
+ */
+void reset_hud(){
+    for (uint8_t a = 0; a < HUD_FIELDS; a++) {
+        hud_fields[a].drawn = 0;
+        hud_fields[a].value = 0;
     }
+    isHudDrawn = false;
 }
 
 ///===============================================================
 //                       Functions
 ///===============================================================
 
+/**
+ *  put a game into the state it has when the teensy is switched on
+ */
+void init_game(struct GameState * game){
+    memset(game, 0, sizeof(*game));
+    game->isPasued = true;
+    game->isFirstStart = true;
+    game->shield_life = SHIELD_LIFE;
+    game->cheat_x = -1;
+    game->cheat_y = -1;
+    game->char_code = 32;
+    game->m_timer = -1;
+    game->o_timer = -1;
+    game->speed = 1;
+    memcpy_P(&game->wave_info, &waves[0], sizeof(game->wave_info));
+    game->cx = 40;
+    game->cy = 40;
+    game->ship.x = 38;
+    game->ship.y = 46;
+}
+
 /**
  *  draw the shield
  */
@@ -303,29 +829,26 @@ void draw_shield(){
 /**
  *  move the spacefighter according to the rules
  */
-void update_spaceship(){
-    if (ship_angle != 1 && ship_angle != 0 && ship_angle != 2) {
-        ship_angle = rand()%2+0;
+void update_spaceship(struct GameState * game){
+    if (game->ship_angle != 1 && game->ship_angle != 0 && game->ship_angle != 2) {
+        game->ship_angle = rand()%2+0;
     }
     // weather the joystick left or right is triggered
-    if (!isPasued) {
-        if (ship_angle == 1 && ship.x > 0 && isPasued == 0 && !(ship.x < 1 || cx < 1)) {
-            ship.x--;
+    if (!game->isPasued) {
+        if (game->ship_angle == 1 && game->ship.x > 0 && game->isPasued == 0 && !(game->ship.x < 1 || game->cx < 1)) {
+            game->ship.x--;
         }
-        else if (ship_angle == 0 && ship.x < LCD_X - 6 && isPasued == 0 && !(ship.x > LCD_X - 7 || cx > LCD_X - 2)) {
-            ship.x++;
+        else if (game->ship_angle == 0 && game->ship.x < LCD_X - 6 && game->isPasued == 0 && !(game->ship.x > LCD_X - 7 || game->cx > LCD_X - 2)) {
+            game->ship.x++;
         }
     }
-    if (((BIT_IS_SET(PINB, 1) || ingame_buffer == 'a') && ship_angle == 0) || ((BIT_IS_SET(PIND, 0) || ingame_buffer == 'd') && ship_angle == 1)) {
-        ship_angle = 2;
-        char_buffer = 32;
+    if (((BIT_IS_SET(game->frame_input.pressed, INPUT_LEFT) || game->ingame_buffer == 'a') && game->ship_angle == 0) || ((BIT_IS_SET(game->frame_input.pressed, INPUT_RIGHT) || game->ingame_buffer == 'd') && game->ship_angle == 1)) {
+        game->ship_angle = 2;
     }
-    else if (BIT_IS_SET(PINB, 1) || ingame_buffer == 'a') {
-        ship_angle = 1;
-        char_buffer = 32;
-    }else if (BIT_IS_SET(PIND, 0) || ingame_buffer == 'd'){
-        ship_angle = 0;
-        char_buffer = 32;
+    else if (BIT_IS_SET(game->frame_input.pressed, INPUT_LEFT) || game->ingame_buffer == 'a') {
+        game->ship_angle = 1;
+    }else if (BIT_IS_SET(game->frame_input.pressed, INPUT_RIGHT) || game->ingame_buffer == 'd'){
+        game->ship_angle = 0;
     }
 }
 
@@ -346,9 +869,10 @@ void draw_plasma(double x, double y){
  *  Parameters:
  *      x: x coordinate
  *      y: y coordinate
+ *      frame: rotation frame
  */
-void draw_asteroid(double x, double y){
-    draw_pixels(x, y, 7, 7, asteroid);
+void draw_asteroid(double x, double y, uint8_t frame){
+    draw_mask(x, y, ASTEROID_SIZE, &asteroid_frames[frame * ASTEROID_SIZE]);
 }
 
 /**
@@ -374,60 +898,111 @@ void draw_fragment(double x, double y){
 }
 
 /**
- *  return: if the asteroid coincides another asteroid
+ *  add an object to a list, or drop it if the list is full
  *  Parameters:
- *      x: x coordinate of the first asteroid
- *      y: y coordinate of the first asteroid
- *      x1: x coordinate of the 2nd asteroid
- *      y1: y coordinate of the 2nd asteroid
- */
-bool asteroid_collision_asteroid(double x, double y, double x1, double y1){
-    return pixel_collision(x, y, 7, 7, asteroid, x1, y1, 7, 7, asteroid);
+ *      list: the list
+ *      counter: the number of objects in the list
+ *      capacity: the size of the list
+ *      x: x coordinate of the object
+ *      y: y coordinate of the object
+ *      angle: the angle of the object
+ *  return: if the object was added
+ */
+bool add_object(struct Object list[], int * counter, int capacity, double x, double y, double angle){
+    if (*counter >= capacity) {
+        return false;
+    }
+    list[*counter].x = x;
+    list[*counter].y = y;
+    list[*counter].angle = angle;
+    (*counter)++;
+    return true;
 }
 
 /**
- *      generate 3 asteroids at random locations
- */
-void spawn_asteroid(){
-    for (int a = 0; a < 3; a++) {
-        int x = rand()%77+0;
-        for (int b = 0; b < 3; b++) {
-            if (asteroid_collision_asteroid(x, -8, asteroid_list[b].x, -8)) {
-                a = 0;
-                break;
+ *      generate a group of asteroids at random locations that do not overlap
+ *
+ *  The width the asteroids leave free is cut at random into the gaps
+ *  before, between and after them, so every group is placed in one pass.
+ *  Parameters:
+ *      count: the number of asteroids, at most SPAWN_GROUP_MAX and the
+ *      room left in the list
+ *
+ *  return: false if the group would land on an asteroid still at the top,
+ *  nothing is spawned then
+ */
+bool spawn_asteroid(struct GameState * game, int count){
+    int cuts[SPAWN_GROUP_MAX];
+    // count random cuts of the free width, kept in order
+    for (int a = 0; a < count; a++) {
+        int cut = rand() % (LCD_X - 7 * count);
+        int b = a;
+        while (b > 0 && cuts[b - 1] > cut) {
+            cuts[b] = cuts[b - 1];
+            b--;
+        }
+        cuts[b] = cut;
+    }
+    // a group let out before the last one has moved far enough, at a low
+    // speed or before the asteroids start falling, must not land on it
+    for (int a = 0; a < count; a++) {
+        int x = cuts[a] + 7 * a;
+        for (int b = 0; b < game->asteroid_counter; b++) {
+            struct Object * asteroid = &game->asteroid_list[b];
+            if (asteroid->y < -1 && asteroid->x < x + 7 && asteroid->x + 7 > x) {
+                return false;
             }
         }
-        asteroid_list[a].y = -8;
-        asteroid_list[a].x = x;
+    }
+    for (int a = 0; a < count; a++) {
+        int x = cuts[a] + 7 * a;
+        if (add_object(game->asteroid_list, &game->asteroid_counter, MAX_ASTEROID, x, -8, 0)) {
+            // start the asteroids at different turns
+            game->asteroid_frame[game->asteroid_counter - 1] = x % SPRITE_FRAMES;
+        }
         if (x + 4 < LCD_X / 2) {
-            leftcounter++;
+            game->leftcounter++;
         }else if (x + 4 >= LCD_X / 2){
-            rightcounter++;
+            game->rightcounter++;
         }
     }
-    asteroid_counter = 3;
-    if (leftcounter > rightcounter) {
-        LED_side = 0;
-    }else if(leftcounter < rightcounter){
-        LED_side = 1;
+    if (game->leftcounter > game->rightcounter) {
+        game->LED_side = 0;
+    }else if(game->leftcounter < game->rightcounter){
+        game->LED_side = 1;
     }
+    game->led_ticks = game->frame_input.ticks;
+    return true;
+}
+
+/**
+ *  return: how far falling objects move each frame, the speed set by the
+ *  player scaled by the wave
+ */
+double fall_speed(struct GameState * game){
+    return game->speed * game->wave_info.speed / 10;
 }
 
 /**
- *   move the asteroids
+ *   move the asteroids, and turn them a frame every ASTEROID_SPIN_TICKS
  */
-void update_asteroid(){
-    if (time >= 2) {
-        for (int a = 0; a < asteroid_counter; a++) {
-            if (!isPasued) {
-                asteroid_list[a].y += speed;
+void update_asteroid(struct GameState * game){
+    if (game->time >= 2) {
+        uint8_t step = game->frame_input.ticks / ASTEROID_SPIN_TICKS;
+        bool turn = step != game->spin_step;
+        game->spin_step = step;
+        for (int a = 0; a < game->asteroid_counter; a++) {
+            if (!game->isPasued) {
+                game->asteroid_list[a].y += fall_speed(game);
+                if (turn) {
+                    game->asteroid_frame[a] = (game->asteroid_frame[a] + 1) % SPRITE_FRAMES;
+                }
             }
-            draw_asteroid(asteroid_list[a].x, asteroid_list[a].y);
+            draw_asteroid(game->asteroid_list[a].x, game->asteroid_list[a].y, game->asteroid_frame[a]);
             // if the asteroid touchs the shield, make it vanish
-            if (asteroid_list[a].y + 7 >= SHIELD_Y && asteroid_list[a].x >= 0 && asteroid_list[a].x <= LCD_X - 7) {
-                asteroid_list[a].y = VANISH;
-                asteroid_counter--;
-                shield_life--;
+            if (game->asteroid_list[a].y + 7 >= SHIELD_Y && game->asteroid_list[a].x >= 0 && game->asteroid_list[a].x <= LCD_X - 7) {
+                game->asteroid_list[a].x = VANISH;
+                game->shield_life--;
             }
         }
     }
@@ -436,38 +1011,37 @@ void update_asteroid(){
 /**
  *  move the connon using the left pot
  */
-void set_cannon_angle(){
+void set_cannon_angle(struct GameState * game){
     // convert the range of angle to (-60 to 60);
-    if (o_timer == -1 || time - o_timer > 1) {
-        leftpotent = round(adc_read(0) / 8.5) - 60;
-        o_timer = -1;
+    if (game->o_timer == -1 || game->time - game->o_timer > 1) {
+        game->leftpotent = round(game->frame_input.left_adc / 8.5) - 60;
+        game->o_timer = -1;
     }
 }
 
 /**
  *  fire a plasma bolt
  */
-void fire_cannon(){
+void fire_cannon(struct GameState * game){
     // if Joystick up
-    if ((BIT_IS_SET(PIND, 1)|| ingame_buffer == 'w') && plasma_counter < MAX_PLASMA && time - plasma_timer >= 0.2 && !isPasued) {
-        plasma_counter++;
-        plasma_list[plasma_counter - 1].x = cx + (PLASMA_LENGTH * sin(leftpotent * M_PI / 180));
-        plasma_list[plasma_counter - 1].y = cy - (PLASMA_LENGTH * cos(leftpotent * M_PI / 180));
-        plasma_list[plasma_counter - 1].angle = leftpotent;
-        plasma_timer = time;
-        ingame_buffer = 32;
+    if ((BIT_IS_SET(game->frame_input.buttons, INPUT_UP)|| game->ingame_buffer == 'w') && game->plasma_counter < MAX_PLASMA && game->time - game->plasma_timer >= 0.2 && !game->isPasued) {
+        game->plasma_counter++;
+        game->plasma_list[game->plasma_counter - 1].x = game->cx + (PLASMA_LENGTH * sin_deg(game->leftpotent));
+        game->plasma_list[game->plasma_counter - 1].y = game->cy - (PLASMA_LENGTH * cos_deg(game->leftpotent));
+        game->plasma_list[game->plasma_counter - 1].angle = game->leftpotent;
+        game->plasma_timer = game->time;
     }
 }
 
 /**
  *  move the plasmas
  */
-void update_plasmas(){
-    for (int a = 0; a < plasma_counter; a++) {
-        draw_plasma(plasma_list[a].x, plasma_list[a].y);
-        if (!isPasued) {
-            plasma_list[a].x += (PLASMA_LENGTH * sin(plasma_list[a].angle * M_PI / 180));
-            plasma_list[a].y -= (PLASMA_LENGTH * cos(plasma_list[a].angle * M_PI / 180));
+void update_plasmas(struct GameState * game){
+    for (int a = 0; a < game->plasma_counter; a++) {
+        draw_plasma(game->plasma_list[a].x, game->plasma_list[a].y);
+        if (!game->isPasued) {
+            game->plasma_list[a].x += (PLASMA_SPEED * sin_deg(game->plasma_list[a].angle));
+            game->plasma_list[a].y -= (PLASMA_SPEED * cos_deg(game->plasma_list[a].angle));
         }
     }
 }
@@ -475,42 +1049,225 @@ void update_plasmas(){
 /**
  *  clear the plasma that is outside the boarder from the list
  */
-void release_plasma_list(){
+void release_plasma_list(struct GameState * game){
     int counter = 0;
-    for (int a = 0; a < plasma_counter; a++) {
-        // if the plasma goes outside the boarder
-        if (plasma_list[a].x > LCD_X || plasma_list[a].x < 0 || plasma_list[a].y < 0) {
-            for (int b = a ;b < plasma_counter; b++) {
-                plasma_list[b] = plasma_list[b + 1];
-            }
-            counter ++;
+    for (int a = 0; a < game->plasma_counter; a++) {
+        // keep the plasma unless it goes outside the boarder
+        if (!(game->plasma_list[a].x > LCD_X || game->plasma_list[a].x < 0 || game->plasma_list[a].y < 0)) {
+            game->plasma_list[counter++] = game->plasma_list[a];
         }
     }
-    plasma_counter -= counter;
+    game->plasma_counter = counter;
 }
 
 /**
  *  draw the connon
  */
-void draw_cannon(){
-    double x2 = ship.x + 2;
-    double y2 = ship.y;
-    int space = ship.y - SHIELD_Y - 2;
-    cx = ship.x + 2 + (space * sin(leftpotent * M_PI / 180));
-    cy = ship.y - (space * cos(leftpotent * M_PI / 180));
-    if (cx < 0) {cx = 0; cy = 41;}
-    else if (cx > LCD_X){cx = LCD_X - 1; cy = 41;}
+void draw_cannon(struct GameState * game){
+    double x2 = game->ship.x + 2;
+    double y2 = game->ship.y;
+    int space = game->ship.y - SHIELD_Y - 2;
+    game->cx = game->ship.x + 2 + (space * sin_deg(game->leftpotent));
+    game->cy = game->ship.y - (space * cos_deg(game->leftpotent));
+    if (game->cx < 0) {game->cx = 0; game->cy = 41;}
+    else if (game->cx > LCD_X){game->cx = LCD_X - 1; game->cy = 41;}
     // draw the connon
-    draw_line(cx, cy, x2, y2, FG_COLOUR);
-    draw_line(cx + 1, cy, x2 + 1, y2, FG_COLOUR);
+    draw_line(game->cx, game->cy, x2, y2, FG_COLOUR);
+    draw_line(game->cx + 1, game->cy, x2 + 1, y2, FG_COLOUR);
 }
 
 /**
  *  draw the space ship
  */
-void draw_spaceship(){
-    draw_pixels(ship.x, ship.y, 6, 2, spaceship);
-    draw_cannon();
+void draw_spaceship(struct GameState * game){
+    draw_pixels(game->ship.x, game->ship.y, 6, 2, spaceship);
+    draw_cannon(game);
+}
+
+/**
+ *  find where the plasma was last frame
+ *  Parameters:
+ *      bolt: the plasma
+ *      x0, y0: set to where the plasma was
+ *      dx, dy: set to how far it moved since
+ *  return: the number of steps of at most one pixel from there to here
+ */
+int plasma_path(struct Object * bolt, double * x0, double * y0, double * dx, double * dy){
+    *dx = PLASMA_SPEED * sin_deg(bolt->angle);
+    *dy = -PLASMA_SPEED * cos_deg(bolt->angle);
+    *x0 = bolt->x - *dx;
+    *y0 = bolt->y - *dy;
+    int steps = ceil(fmax(fabs(*dx), fabs(*dy)));
+    return steps < 1 ? 1 : steps;
+}
+
+/**
+ *  return: if the plasma hits the shape anywhere on the way from where it
+ *  was last frame to where it is now, so a fast bolt can not jump over it
+ *  Parameters:
+ *      x: x coordinate of the shape
+ *      y: y coordinate of the shape
+ *      w: width of the shape
+ *      h: height of the shape
+ *      pixels: formatted shape
+ *      mask: packed shape used in place of pixels, or NULL
+ *      bolt: the plasma
+ */
+bool plasma_swept_collision(int x, int y, int w, int h, const char pixels[], const uint8_t mask[], struct Object * bolt){
+    double x0, y0, dx, dy;
+    int steps = plasma_path(bolt, &x0, &y0, &dx, &dy);
+    int left = x0 < bolt->x ? x0 : bolt->x;
+    int right = x0 < bolt->x ? bolt->x : x0;
+    int top = y0 < bolt->y ? y0 : bolt->y;
+    int bottom = y0 < bolt->y ? bolt->y : y0;
+    // most bolts are nowhere near, so check the box around the whole way first
+    if (right + 2 <= x || left >= x + w || bottom + 2 <= y || top >= y + h) {
+        return false;
+    }
+    // then check every pixel along the way
+    for (int a = 1; a <= steps; a++) {
+        int px = x0 + dx * a / steps;
+        int py = y0 + dy * a / steps;
+        if (mask ? mask_collision(x, y, h, mask, px, py) : pixel_collision(x, y, w, h, pixels, px, py, 2, 2, plasma)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// owner ids of the targets in the occupancy bitmap, 0 is no target and
+// each list follows the last
+#define OWNER_ASTEROID 1
+#define OWNER_BOULDER (OWNER_ASTEROID + MAX_ASTEROID)
+#define OWNER_FRAGMENT (OWNER_BOULDER + MAX_BOULDER)
+// a strip of more than one target
+#define OWNER_SHARED 0xFF
+_Static_assert(OWNER_FRAGMENT + MAX_FRAGMENT <= OWNER_SHARED, "every target needs an owner id");
+
+// most targets one plasma is tested against, and what plasma_owners
+// returns when it must be tested against all of them
+#define OWNER_CANDIDATES 4
+#define OWNERS_ALL 0xFF
+
+/**
+ *  return: if the plasma may have hit the target
+ *  Parameters:
+ *      owners: the owner ids found by plasma_owners
+ *      count: the number found, or OWNERS_ALL
+ *      owner: owner id of the target
+ */
+bool owner_listed(const uint8_t owners[], uint8_t count, uint8_t owner){
+    if (count == OWNERS_ALL) {
+        return true;
+    }
+    for (int a = 0; a < count; a++) {
+        if (owners[a] == owner) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if COLLISION_BITMAP
+/**
+ *  draw a list of targets into the occupancy bitmap, every strip they
+ *  cover gets their owner id, or OWNER_SHARED if another target has it
+ *  Parameters:
+ *      objects: the targets
+ *      counter: the number of targets
+ *      owner: owner id of the first target, the others follow on
+ *      w: width of the targets
+ *      h: height of the targets
+ *      pixels: formatted shape of the targets
+ *      masks: packed rotation frames used in place of pixels, or NULL
+ *      frames: the rotation frame of each target, used with masks
+ */
+void occupy_objects(struct Object objects[], int counter, uint8_t owner, int w, int h, const char pixels[], const uint8_t masks[], const uint8_t frames[]){
+    for (int a = 0; a < counter; a++, owner++) {
+        for (int j = 0; j < h; j++) {
+            int y = (int) objects[a].y + j;
+            for (int i = 0; i < w; i++) {
+                int x = (int) objects[a].x + i;
+                bool set = masks ? pgm_read_byte(&masks[frames[a] * h + j]) & BIT(i)
+                                 : pgm_read_byte(&pixels[i + j * w]) != ' ';
+                if (set && x >= 0 && x < LCD_X && y >= 0 && y < LCD_Y) {
+                    uint8_t * strip = &occupancy[(y >> 3) * LCD_X + x];
+                    *strip = (*strip == 0 || *strip == owner) ? owner : OWNER_SHARED;
+                }
+            }
+        }
+    }
+}
+
+/**
+ *  find the targets in the occupancy bitmap the plasma may hit on its way
+ *  here, it is sure to miss every other target
+ *  Parameters:
+ *      bolt: the plasma
+ *      owners: set to the owner ids found, OWNER_CANDIDATES at most
+ *  return: the number of owner ids found, or OWNERS_ALL if the plasma
+ *  must be tested against every target
+ */
+uint8_t plasma_owners(struct Object * bolt, uint8_t owners[]){
+    double x0, y0, dx, dy;
+    int steps = plasma_path(bolt, &x0, &y0, &dx, &dy);
+    uint8_t count = 0;
+    for (int a = 1; a <= steps; a++) {
+        int x = x0 + dx * a / steps;
+        int y = y0 + dy * a / steps;
+        // off the bitmap, leave it to pixel_collision
+        if (x < 0 || x + 1 >= LCD_X || y < 0 || y + 1 >= LCD_Y) {
+            return OWNERS_ALL;
+        }
+        // the 2x2 plasma covers 2 columns of 1 or 2 banks
+        uint8_t * column = &occupancy[(y >> 3) * LCD_X + x];
+        uint8_t strips[4] = {column[0], column[1], 0, 0};
+        if ((y & 7) == 7) {
+            strips[2] = column[LCD_X];
+            strips[3] = column[LCD_X + 1];
+        }
+        for (int b = 0; b < 4; b++) {
+            if (strips[b] == 0 || owner_listed(owners, count, strips[b])) {
+                continue;
+            }
+            if (strips[b] == OWNER_SHARED || count == OWNER_CANDIDATES) {
+                return OWNERS_ALL;
+            }
+            owners[count++] = strips[b];
+        }
+    }
+    return count;
+}
+#else
+void occupy_objects(struct Object objects[], int counter, uint8_t owner, int w, int h, const char pixels[], const uint8_t masks[], const uint8_t frames[]){
+    (void) objects;
+    (void) counter;
+    (void) owner;
+    (void) w;
+    (void) h;
+    (void) pixels;
+    (void) masks;
+    (void) frames;
+}
+
+uint8_t plasma_owners(struct Object * bolt, uint8_t owners[]){
+    (void) bolt;
+    (void) owners;
+    return OWNERS_ALL;
+}
+#endif
+
+/**
+ *  draw every target into the occupancy bitmap, once a frame before the
+ *  plasma is tested against them
+ */
+void occupy_targets(struct GameState * game){
+#if COLLISION_BITMAP
+    memset(occupancy, 0, sizeof(occupancy));
+#endif
+    occupy_objects(game->asteroid_list, game->asteroid_counter, OWNER_ASTEROID, ASTEROID_SIZE, ASTEROID_SIZE, NULL, asteroid_frames, game->asteroid_frame);
+    occupy_objects(game->boulder_list, game->boulder_counter, OWNER_BOULDER, 5, 5, boulder, NULL, NULL);
+    occupy_objects(game->fragment_list, game->fragment_counter, OWNER_FRAGMENT, 3, 3, fragment, NULL, NULL);
 }
 
 /**
@@ -518,11 +1275,11 @@ void draw_spaceship(){
  *  Parameters:
  *      x: x coordinate of asteroid
  *      y: y coordinate of asteroid
- *      x1: x coordinate of plasma
- *      y1: y coordinate of plasma
+ *      frame: rotation frame of the asteroid
+ *      bolt: the plasma
  */
-bool asteroid_hit_by_plasma(double x, double y, double x1, double y1){
-    return pixel_collision(x, y, 7, 7, asteroid, x1, y1, 2, 2, plasma);
+bool asteroid_hit_by_plasma(double x, double y, uint8_t frame, struct Object * bolt){
+    return plasma_swept_collision(x, y, ASTEROID_SIZE, ASTEROID_SIZE, NULL, &asteroid_frames[frame * ASTEROID_SIZE], bolt);
 }
 
 /**
@@ -530,11 +1287,10 @@ bool asteroid_hit_by_plasma(double x, double y, double x1, double y1){
  *  Parameters:
  *      x: x coordinate of the boulder
  *      y: y coordinate of the boulder
- *      x1: x coordinate of plasma
- *      y1: y coordinate of plasma
+ *      bolt: the plasma
  */
-bool boulder_hit_by_plasma(double x, double y, double x1, double y1){
-    return pixel_collision(x, y, 5, 5, boulder, x1, y1, 2, 2, plasma);
+bool boulder_hit_by_plasma(double x, double y, struct Object * bolt){
+    return plasma_swept_collision(x, y, 5, 5, boulder, NULL, bolt);
 }
 
 /**
@@ -542,55 +1298,58 @@ bool boulder_hit_by_plasma(double x, double y, double x1, double y1){
  *  Parameters:
  *      x: x coordinate of the fragment
  *      y: y coordinate of the fragment
- *      x1: x coordinate of the plasma
- *      y1: y coordinate of the plasma
+ *      bolt: the plasma
  */
-bool fragment_hit_by_plasma(double x, double y, double x1, double y1){
-    return pixel_collision(x, y, 3, 3, fragment, x1, y1, 2, 2, plasma);
+bool fragment_hit_by_plasma(double x, double y, struct Object * bolt){
+    return plasma_swept_collision(x, y, 3, 3, fragment, NULL, bolt);
 }
 
 /**
- *  generate 2 boulders at the given position
+ *  generate 2 boulders at the given position, or 1 in the middle of them
+ *  if the wave splits asteroids in 1 or there is only room for 1
  *  Parameters:
+ *      game: the game
  *      x: x coordinate of the boulder
  *      y: y coordinate of the boulder
  */
-void spawn_boulders(double x, double y){
+void spawn_boulders(struct GameState * game, double x, double y){
     while (x < 0) {
         x++;
     }
     while (x + 5 > LCD_X) {
         x--;
     }
-    boulder_list[boulder_counter].x = x;
-    boulder_list[boulder_counter].y = y;
-    boulder_list[boulder_counter].angle = rand()%61+(-30);
-    
-    boulder_list[boulder_counter + 1].x = x + 2;
-    boulder_list[boulder_counter + 1].y = y;
-    boulder_list[boulder_counter + 1].angle = rand()%61+(-30);
-    
-    boulder_counter += 2;
+    if (game->wave_info.pieces >= 2 && game->boulder_counter + 2 <= MAX_BOULDER) {
+        add_object(game->boulder_list, &game->boulder_counter, MAX_BOULDER, x, y, rand()%61+(-30));
+        add_object(game->boulder_list, &game->boulder_counter, MAX_BOULDER, x + 2, y, rand()%61+(-30));
+    }else{
+        if (game->wave_info.pieces >= 2) {
+            game->wave_dropped++;
+        }
+        if (!add_object(game->boulder_list, &game->boulder_counter, MAX_BOULDER, x + 1, y, rand()%61+(-30))) {
+            game->wave_dropped++;
+        }
+    }
 }
 
 /**
  *  move the boulders
  */
-void update_boulders(){
-    for (int a = 0; a < boulder_counter; a++) {
-        draw_boulder(boulder_list[a].x, boulder_list[a].y);
-        if (!isPasued) {
-            boulder_list[a].x += speed * sin(boulder_list[a].angle * M_PI / 180);
-            boulder_list[a].y += speed * cos(boulder_list[a].angle * M_PI / 180);
+void update_boulders(struct GameState * game){
+    for (int a = 0; a < game->boulder_counter; a++) {
+        draw_boulder(game->boulder_list[a].x, game->boulder_list[a].y);
+        if (!game->isPasued) {
+            game->boulder_list[a].x += fall_speed(game) * sin_deg(game->boulder_list[a].angle);
+            game->boulder_list[a].y += fall_speed(game) * cos_deg(game->boulder_list[a].angle);
         }
         // if the boulder hits the boarder, make it bounce
-        if (boulder_list[a].x < 1 || boulder_list[a].x > LCD_X - 5) {
-            boulder_list[a].angle = - boulder_list[a].angle;
+        if (game->boulder_list[a].x < 1 || game->boulder_list[a].x > LCD_X - 5) {
+            game->boulder_list[a].angle = - game->boulder_list[a].angle;
         }
         // if the boulder hits the shield, make it vanish
-        if (boulder_list[a].y > SHIELD_Y - 4 && boulder_list[a].x >= 0 && boulder_list[a].x < LCD_X - 5) {
-            boulder_list[a].x = VANISH;
-            shield_life--;
+        if (game->boulder_list[a].y > SHIELD_Y - 4 && game->boulder_list[a].x >= 0 && game->boulder_list[a].x < LCD_X - 5) {
+            game->boulder_list[a].x = VANISH;
+            game->shield_life--;
         }
     }
 }
@@ -598,21 +1357,21 @@ void update_boulders(){
 /**
  *  move the fragments
  */
-void update_fragments(){
-    for (int a = 0; a < fragment_counter; a++) {
-        draw_fragment(fragment_list[a].x, fragment_list[a].y);
-        if (!isPasued) {
-            fragment_list[a].x += speed * sin(fragment_list[a].angle * M_PI / 180);
-            fragment_list[a].y += speed * cos(fragment_list[a].angle * M_PI / 180);
+void update_fragments(struct GameState * game){
+    for (int a = 0; a < game->fragment_counter; a++) {
+        draw_fragment(game->fragment_list[a].x, game->fragment_list[a].y);
+        if (!game->isPasued) {
+            game->fragment_list[a].x += fall_speed(game) * sin_deg(game->fragment_list[a].angle);
+            game->fragment_list[a].y += fall_speed(game) * cos_deg(game->fragment_list[a].angle);
         }
         // if the fragment hits the boarder, make it bounce
-        if (fragment_list[a].x < 1 || fragment_list[a].x > LCD_X - 3) {
-            fragment_list[a].angle = -fragment_list[a].angle;
+        if (game->fragment_list[a].x < 1 || game->fragment_list[a].x > LCD_X - 3) {
+            game->fragment_list[a].angle = -game->fragment_list[a].angle;
         }
         // if the fragment hits the shield, make it vanish
-        if (fragment_list[a].y > SHIELD_Y - 2 && fragment_list[a].x >= 0 && fragment_list[a].x <= LCD_X - 3) {
-            fragment_list[a].x = VANISH;
-            shield_life--;
+        if (game->fragment_list[a].y > SHIELD_Y - 2 && game->fragment_list[a].x >= 0 && game->fragment_list[a].x <= LCD_X - 3) {
+            game->fragment_list[a].x = VANISH;
+            game->shield_life--;
         }
     }
 }
@@ -620,70 +1379,84 @@ void update_fragments(){
 /**
  * delete the asteroids that hit the boarder of hit by plasma
  */
-void release_asteroid_list(){
+void release_asteroid_list(struct GameState * game){
     int counter = 0;
-    for (int a = 0; a < asteroid_counter; a++) {
-        if (asteroid_list[a].x > LCD_X) {
-            for (int b = a; b < asteroid_counter; b++) {
-                asteroid_list[b] = asteroid_list[b + 1];
-            }
-            counter++;
+    for (int a = 0; a < game->asteroid_counter; a++) {
+        if (game->asteroid_list[a].x <= LCD_X) {
+            game->asteroid_frame[counter] = game->asteroid_frame[a];
+            game->asteroid_list[counter++] = game->asteroid_list[a];
         }
     }
-    asteroid_counter -= counter;
+    game->asteroid_counter = counter;
 }
 
 /**
  *  make the asteroid disapper if it hits by a plasma
  */
-void asteroid_detection(){
-    for (int a = 0; a < plasma_counter; a++) {
-        for (int b = 0; b < asteroid_counter; b++) {
+void asteroid_detection(struct GameState * game){
+    uint8_t owners[OWNER_CANDIDATES];
+    for (int a = 0; a < game->plasma_counter; a++) {
+        uint8_t count = plasma_owners(&game->plasma_list[a], owners);
+        for (int b = 0; b < game->asteroid_counter && count > 0; b++) {
             //if any asteroid is hitted
-            if (asteroid_hit_by_plasma(asteroid_list[b].x, asteroid_list[b].y, plasma_list[a].x, plasma_list[a].y)) {
-                score++;
-                spawn_boulders(asteroid_list[b].x + 1, asteroid_list[b].y);
-                asteroid_list[b].x = VANISH;
-                plasma_list[a].x =  -999;
+            if (owner_listed(owners, count, OWNER_ASTEROID + b)
+                && asteroid_hit_by_plasma(game->asteroid_list[b].x, game->asteroid_list[b].y, game->asteroid_frame[b], &game->plasma_list[a])) {
+                game->score++;
+                int first = game->boulder_counter;
+                spawn_boulders(game, game->asteroid_list[b].x + 1, game->asteroid_list[b].y);
+                // the other plasma can hit the new boulders this frame
+                occupy_objects(&game->boulder_list[first], game->boulder_counter - first, OWNER_BOULDER + first, 5, 5, boulder, NULL, NULL);
+                explode(game->asteroid_list[b].x + 3, game->asteroid_list[b].y + 3, 8);
+                game->asteroid_list[b].x = VANISH;
+                game->plasma_list[a].x =  -999;
             }
         }
     }
 }
 
 /**
- *  generate 2 fragment at the given position and assign the angle to them
+ *  generate 2 fragment at the given position and assign the angle to them,
+ *  or 1 in the middle of them if the wave splits boulders in 1 or there is
+ *  only room for 1
+ *      game: the game
  *      x: x coordinate of the fragment
  *      y: y coordinate of the fragment
  *      angle: the angle of the hitted object
  */
-void spawn_fragment(double x, double y, double angle){
+void spawn_fragment(struct GameState * game, double x, double y, double angle){
     while (x < 3) {
         x++;
     }
     while (x + 10 > LCD_X) {
         x--;
     }
-    fragment_list[fragment_counter].x = x - 3;
-    fragment_list[fragment_counter].y = y;
-    fragment_list[fragment_counter].angle = angle + rand()%61+(-30);
-    
-    fragment_list[fragment_counter + 1].x = x + 5;
-    fragment_list[fragment_counter + 1].y = y;
-    fragment_list[fragment_counter + 1].angle = angle + rand()%61+(-30);
-    
-    fragment_counter += 2;
+    if (game->wave_info.pieces >= 2 && game->fragment_counter + 2 <= MAX_FRAGMENT) {
+        add_object(game->fragment_list, &game->fragment_counter, MAX_FRAGMENT, x - 3, y, angle + rand()%61+(-30));
+        add_object(game->fragment_list, &game->fragment_counter, MAX_FRAGMENT, x + 5, y, angle + rand()%61+(-30));
+    }else{
+        if (game->wave_info.pieces >= 2) {
+            game->wave_dropped++;
+        }
+        if (!add_object(game->fragment_list, &game->fragment_counter, MAX_FRAGMENT, x + 1, y, angle + rand()%61+(-30))) {
+            game->wave_dropped++;
+        }
+    }
 }
 
 /**
  *  make the fragment disapper if its hitted by plasma or the shield
  */
-void fragment_detection(){
-    for (int a = 0; a < plasma_counter; a++) {
-        for (int b = 0; b < fragment_counter; b++) {
-            if (fragment_hit_by_plasma(fragment_list[b].x, fragment_list[b].y, plasma_list[a].x, plasma_list[a].y)) {
-                score+=4;
-                fragment_list[b].x = VANISH;
-                plasma_list[a].x =  -999;
+void fragment_detection(struct GameState * game){
+    uint8_t owners[OWNER_CANDIDATES];
+    for (int a = 0; a < game->plasma_counter; a++) {
+        uint8_t count = plasma_owners(&game->plasma_list[a], owners);
+        for (int b = 0; b < game->fragment_counter && count > 0; b++) {
+            if (owner_listed(owners, count, OWNER_FRAGMENT + b)
+                && fragment_hit_by_plasma(game->fragment_list[b].x, game->fragment_list[b].y, &game->plasma_list[a])) {
+                game->score+=4;
+                explode(game->fragment_list[b].x + 1, game->fragment_list[b].y + 1, 4);
+                game->fragment_list[b].x = VANISH;
+                game->plasma_list[a].x =  -999;
             }
         }
     }
@@ -692,15 +1465,22 @@ void fragment_detection(){
 /**
  *  make the boulder disapper if its hitted by plasma or the shield
  */
-void boulder_detection(){
-    for (int a = 0; a < plasma_counter; a++) {
-        for (int b = 0; b < boulder_counter; b++) {
+void boulder_detection(struct GameState * game){
+    uint8_t owners[OWNER_CANDIDATES];
+    for (int a = 0; a < game->plasma_counter; a++) {
+        uint8_t count = plasma_owners(&game->plasma_list[a], owners);
+        for (int b = 0; b < game->boulder_counter && count > 0; b++) {
             // if any boulder is hitted by plasma
-            if (boulder_hit_by_plasma(boulder_list[b].x, boulder_list[b].y, plasma_list[a].x, plasma_list[a].y)) {
-                score+=2;
-                spawn_fragment(boulder_list[b].x, boulder_list[b].y, boulder_list[b].angle);
-                boulder_list[b].x = VANISH;
-                plasma_list[a].x = -999;
+            if (owner_listed(owners, count, OWNER_BOULDER + b)
+                && boulder_hit_by_plasma(game->boulder_list[b].x, game->boulder_list[b].y, &game->plasma_list[a])) {
+                game->score+=2;
+                int first = game->fragment_counter;
+                spawn_fragment(game, game->boulder_list[b].x, game->boulder_list[b].y, game->boulder_list[b].angle);
+                // the other plasma can hit the new fragments this frame
+                occupy_objects(&game->fragment_list[first], game->fragment_counter - first, OWNER_FRAGMENT + first, 3, 3, fragment, NULL, NULL);
+                explode(game->boulder_list[b].x + 2, game->boulder_list[b].y + 2, 6);
+                game->boulder_list[b].x = VANISH;
+                game->plasma_list[a].x = -999;
             }
         }
     }
@@ -709,41 +1489,85 @@ void boulder_detection(){
 /**
  *  remove the boulders that are outside the boarder from the list
  */
-void release_boulder_list(){
+void release_boulder_list(struct GameState * game){
     int counter = 0;
-    for (int a = 0; a < boulder_counter; a++) {
-        if (boulder_list[a].x > LCD_X) {
-            for (int b = a; b < boulder_counter; b++) {
-                boulder_list[b] = boulder_list[b + 1];
-            }
-            counter++;
+    for (int a = 0; a < game->boulder_counter; a++) {
+        if (game->boulder_list[a].x <= LCD_X) {
+            game->boulder_list[counter++] = game->boulder_list[a];
         }
     }
-    boulder_counter -= counter;
+    game->boulder_counter = counter;
 }
 
 /**
  *  remove the fragments that are outside the boarder from the list
  */
-void release_fragment_list(){
+void release_fragment_list(struct GameState * game){
     int counter = 0;
-    for (int a = 0; a < fragment_counter; a++) {
-        if (fragment_list[a].x > LCD_X) {
-            for (int b = a; b < fragment_counter; b++) {
-                fragment_list[b] = fragment_list[b + 1];
-            }
-            counter++;
+    for (int a = 0; a < game->fragment_counter; a++) {
+        if (game->fragment_list[a].x <= LCD_X) {
+            game->fragment_list[counter++] = game->fragment_list[a];
         }
     }
-    fragment_counter -= counter;
+    game->fragment_counter = counter;
 }
 
 /**
- *  respawn 3 asteroids if theres no falling objects on screen
+ *  load the next wave from the waves table and queue its asteroids
  */
-void respawn_asteroid(){
-    if (asteroid_counter == 0 && boulder_counter == 0 && fragment_counter == 0) {
-        spawn_asteroid();
+void start_wave(struct GameState * game){
+    uint8_t index = game->wave < WAVE_COUNT ? game->wave : WAVE_COUNT - 1;
+    memcpy_P(&game->wave_info, &waves[index], sizeof(game->wave_info));
+    if (game->wave >= WAVE_COUNT) {
+        int asteroids = game->wave_info.asteroids + (game->wave - WAVE_COUNT + 1) * WAVE_GROWTH;
+        game->wave_info.asteroids = asteroids < UINT8_MAX ? asteroids : UINT8_MAX;
+    }
+    if (game->wave < UINT8_MAX) {
+        game->wave++;
+    }
+    game->spawn_pending = game->wave_info.asteroids;
+    game->spawn_timer = 0;
+    game->wave_dropped = 0;
+}
+
+/**
+ *  start the next wave if theres no falling objects on screen
+ */
+void respawn_asteroid(struct GameState * game){
+    if (game->asteroid_counter == 0 && game->boulder_counter == 0 && game->fragment_counter == 0
+        && game->spawn_pending == 0) {
+        start_wave(game);
+    }
+}
+
+/**
+ *  spawn the next group of queued asteroids once its interval is up and
+ *  there is room for it in the asteroid list, so a big wave comes in a
+ *  few at a time. a group with no clear place is tried again next frame
+ */
+void spawn_queued_asteroids(struct GameState * game){
+    if (game->spawn_pending == 0) {
+        return;
+    }
+    if (game->spawn_timer > 0) {
+        if (!game->isPasued) {
+            game->spawn_timer--;
+        }
+        return;
+    }
+    int count = game->wave_info.group;
+    if (count > SPAWN_GROUP_MAX) {
+        count = SPAWN_GROUP_MAX;
+    }
+    if (count > game->spawn_pending) {
+        count = game->spawn_pending;
+    }
+    if (count > MAX_ASTEROID - game->asteroid_counter) {
+        count = MAX_ASTEROID - game->asteroid_counter;
+    }
+    if (count > 0 && spawn_asteroid(game, count)) {
+        game->spawn_pending -= count;
+        game->spawn_timer = game->wave_info.interval;
     }
 }
 
@@ -761,104 +1585,99 @@ void draw_boarder(){
  *  display intro information on teensy screen
  */
 void introduction_information(){
-    draw_string(20, 3, "n10088652", FG_COLOUR);
-    draw_string(22, 20, "Asteroid", FG_COLOUR);
-    draw_string(18, 27, "Apocalypse", FG_COLOUR);
+    draw_string_P(20, 3, PSTR("n10088652"), FG_COLOUR);
+    draw_string_P(22, 20, PSTR("Asteroid"), FG_COLOUR);
+    draw_string_P(18, 27, PSTR("Apocalypse"), FG_COLOUR);
 }
 
 /**
- *  intro page
+ *  draw one frame of the intro page, moving the dashes
  */
 void display_introduction(){
-    int brightness = 1023;
-    struct Animation{
-        int x, y, angle;
-    };
-    struct Animation a = {-1, 12, 1};
-    struct Animation b = {LCD_X, 12, -1};
-    while (!BIT_IS_SET(PINF, 6) && usb_serial_getchar() != 'r') {
-        if (brightness > 15) {
-            brightness -= 15;
-        }
-        set_duty_cycle(brightness);
-        clear_screen();
-        introduction_information();
-        if (a.angle == 1) {
-            a.x++;
-        }else if(a.angle == -1){
-            a.x--;
-        }
-        if (b.angle == 1) {
-            b.x++;
-        }else if(b.angle == -1){
-            b.x--;
-        }
-        if (a.x > LCD_X || a.x < 0) {
-            a.angle = -a.angle;
-        }
-        if (b.x > LCD_X || b.x < 0) {
-            b.angle = -b.angle;
+    clear_screen();
+    introduction_information();
+    for (uint8_t d = 0; d < 2; d++) {
+        struct Animation * dash = &intro_dashes[d];
+        dash->x += dash->angle;
+        if (dash->x > LCD_X || dash->x < 0) {
+            dash->angle = -dash->angle;
         }
-        draw_pixels(a.x, a.y, 5, 1, animation);
-        draw_pixels(b.x, b.y, 5, 1, animation);
-        draw_boarder();
-        show_screen();
+        draw_pixels(dash->x, dash->y, 5, 1, animation);
     }
-    
+    draw_boarder();
+    show_frame();
 }
 
 /**
  *  remove all objects that are outside the boarder from lists
  */
-void release_all_list(){
-    release_plasma_list();
-    release_asteroid_list();
-    release_boulder_list();
-    release_fragment_list();
+void release_all_list(struct GameState * game){
+    release_plasma_list(game);
+    release_asteroid_list(game);
+    release_boulder_list(game);
+    release_fragment_list(game);
 }
 
 /**
  *  detect if any falling object is hiited
  */
-void collision_detection(){
-    asteroid_detection();
-    boulder_detection();
-    fragment_detection();
+void collision_detection(struct GameState * game){
+    occupy_targets(game);
+    asteroid_detection(game);
+    boulder_detection(game);
+    fragment_detection(game);
 }
 
 /**
  *  display the current game time on teensy screen
+ *  return: if it was drawn
  */
-void display_time(){
-    int min = floor(time / 60);
-    int sec = floor(time - min * 60);
-    if (sec < 10) {
-        draw_int(46, 7, 0, FG_COLOUR);
-        draw_int(52, 7, sec, FG_COLOUR);
-    }else{
-        draw_int(46, 7, sec, FG_COLOUR);
+bool display_time(struct GameState * game){
+    int min = floor(game->time / 60);
+    int sec = floor(game->time - min * 60);
+    bool changed = hud_set(HUD_MINUTES, min);
+    return hud_set(HUD_SECONDS, sec) || changed;
+}
+
+/**
+ *  display game inforamtions on teensy screen, the labels are drawn once
+ *  and the numbers only when they change, and the screen is only sent
+ *  when something was drawn
+ */
+void display_statues_teensy(struct GameState * game){
+    bool changed = false;
+    if (!isHudDrawn) {
+        clear_screen();
+        draw_string_P(3, 7, PSTR("Time: "), FG_COLOUR);
+        draw_char(41, 7, ':', FG_COLOUR);
+        draw_string_P(5, 17, PSTR("Life: "), FG_COLOUR);
+        draw_string_P(5, 27, PSTR("Score: "), FG_COLOUR);
+        for (uint8_t a = 0; a < HUD_FIELDS; a++) {
+            hud_fields[a].drawn = 0;
+        }
+        changed = true;
     }
-    if (min < 10) {
-        draw_int(35, 7, min, FG_COLOUR);
-        draw_int(29, 7, 0, FG_COLOUR);
+    changed = display_time(game) || changed;
+    changed = hud_set(HUD_LIFE, game->shield_life) || changed;
+    changed = hud_set(HUD_SCORE, game->score) || changed;
+    isHudDrawn = true;
+    if (changed) {
+        show_frame();
     }else{
-        draw_int(29, 7, min, FG_COLOUR);
+        // the screen already shows this frame
+        count_latency();
     }
-    draw_char(41, 7, ':', FG_COLOUR);
 }
 
 /**
- *  display game inforamtions on teensy screen
+ *  send a number to computer
+ *  Parameters:
+ *      number: the number that will be sent to the computer
  */
-void display_statues_teensy(){
-    clear_screen();
-    draw_string(3, 7, "Time: ", FG_COLOUR);
-    draw_string(5, 17, "Life: ", FG_COLOUR);
-    draw_int(32, 17, shield_life, FG_COLOUR);
-    draw_string(5, 27, "Score: ", FG_COLOUR);
-    draw_int(40, 27, score, FG_COLOUR);
-    display_time();
-    show_screen();
+void send_num_to(int number){
+    char snum[FORMAT_INT_SIZE];
+    uint8_t length = format_int(snum, sizeof(snum), number, 1);
+    usb_serial_write((uint8_t *) snum, length);
 }
 
 /**
@@ -867,94 +1686,251 @@ void display_statues_teensy(){
  *      message: the message that will be sent to computer
  *      number: the number that will be sent to computer
  */
-void send_to(char * message, int number){
-    char snum[5];
-    usb_serial_send(message);
-    itoa(number, snum, 10);
-    usb_serial_send(snum);
-    usb_serial_send("\r\n");
+void send_to(const char * message, int number){
+    usb_serial_send_P(message);
+    send_num_to(number);
+    usb_serial_send_P(PSTR("\r\n"));
 }
 
 /**
- *  send a number to computer
+ *  send the current game time to the computer
+ */
+void send_time(struct GameState * game){
+    char text[8];
+    uint8_t length = format_time(text, sizeof(text), game->time);
+    usb_serial_send_P(PSTR("Game Time: "));
+    usb_serial_write((uint8_t *) text, length);
+    usb_serial_send_P(PSTR("\r\n"));
+}
+
+/**
+ *  send all game informations the computer
+ */
+void display_statues_computer(struct GameState * game){
+    send_time(game);
+    send_to(PSTR("Lives: "), game->shield_life);
+    send_to(PSTR("Score: "), game->score);
+    send_to(PSTR("Asteroids: "), game->asteroid_counter);
+    send_to(PSTR("Boulders: "), game->boulder_counter);
+    send_to(PSTR("Fragments: "), game->fragment_counter);
+    send_to(PSTR("Plasma: "), game->plasma_counter);
+    send_to(PSTR("Turrent: "), game->leftpotent);
+    send_to(PSTR("Speed: "), game->speed * 10);
+    usb_serial_send_P(PSTR(" \r\n"));
+}
+
+/**
+ *  send the position of every object in a list to computer
  *  Parameters:
- *      number: the number that will be sent to the computer
+ *      name: the name of the objects
+ *      objects: the object list
+ *      counter: the number of objects in the list
+ */
+void send_object_list(const char * name, struct Object objects[], int counter){
+    for (int a = 0; a < counter; a++) {
+        usb_serial_send_P(name);
+        send_num_to(objects[a].x);
+        usb_serial_send_P(PSTR(","));
+        send_num_to(objects[a].y);
+        usb_serial_send_P(PSTR("\r\n"));
+    }
+}
+
+/**
+ *  send the state of all objects and the screen to computer, so the
+ *  expected outcomes in Tests.txt can be checked by a script
  */
-void send_num_to(int number){
-    char snum[5];
-    itoa(number, snum, 10);
-    usb_serial_send(snum);
+void send_state(struct GameState * game){
+    usb_serial_send_P(PSTR("#X\r\n"));
+    send_to(PSTR("Paused: "), game->isPasued);
+    send_to(PSTR("Lives: "), game->shield_life);
+    send_to(PSTR("Score: "), game->score);
+    send_to(PSTR("Turrent: "), game->leftpotent);
+    usb_serial_send_P(PSTR("Ship: "));
+    send_num_to(game->ship.x);
+    usb_serial_send_P(PSTR(","));
+    send_num_to(game->ship.y);
+    usb_serial_send_P(PSTR("\r\n"));
+    send_object_list(PSTR("Asteroid: "), game->asteroid_list, game->asteroid_counter);
+    send_object_list(PSTR("Boulder: "), game->boulder_list, game->boulder_counter);
+    send_object_list(PSTR("Fragment: "), game->fragment_list, game->fragment_counter);
+    send_object_list(PSTR("Plasma: "), game->plasma_list, game->plasma_counter);
+    usb_serial_send_P(PSTR("#L"));
+    usb_serial_send_hex(screen_buffer, LCD_BUFFER_SIZE);
+    usb_serial_send_P(PSTR("\r\n"));
 }
 
 /**
- *  send the current game time to the computer
+ *  determine if the state should be sent at the end of this frame
  */
-void send_time(){
-    int min = floor(time / 60);
-    int sec = floor(time - min * 60);
-    usb_serial_send("Game Time: ");
-    if (min < 10) {
-        send_num_to(0);
-        send_num_to(min);
-    }else{
-        send_num_to(min);
+void request_state(struct GameState * game){
+    if (game->ingame_buffer == 'x') {
+        isStateRequested = true;
     }
-    usb_serial_send(":");
-    if (sec < 10) {
-        send_num_to(0);
-        send_num_to(sec);
-    }else{
-        send_num_to(sec);
+}
+
+/**
+ *  send the state once the frame is on the screen
+ */
+void send_requested_state(struct GameState * game){
+    if (isStateRequested) {
+        send_state(game);
+        isStateRequested = false;
     }
-    usb_serial_send("\r\n");
 }
 
 /**
- *  send all game informations the computer
+ *  send a latency figure to computer
+ *  Parameters:
+ *      message: the name of the figure
+ *      number: the figure in milliseconds
+ */
+void send_latency(const char * message, uint16_t number){
+    char snum[FORMAT_INT_SIZE];
+    usb_serial_send_P(message);
+    uint8_t length = format_uint(snum, sizeof(snum), number, 1);
+    usb_serial_write((uint8_t *) snum, length);
+    usb_serial_send_P(PSTR(" ms\r\n"));
+}
+
+/**
+ *  send the wave metrics to computer
  */
-void display_statues_computer(){
-    send_time();
-    send_to("Lives: ", shield_life);
-    send_to("Score: ", score);
-    send_to("Asteroids: ", asteroid_counter);
-    send_to("Boulders: ", boulder_counter);
-    send_to("Fragments: ", fragment_counter);
-    send_to("Plasma: ", plasma_counter);
-    send_to("Turrent: ", leftpotent);
-    send_to("Speed: ", speed * 10);
-    usb_serial_send(" \r\n");
+void send_wave(struct GameState * game){
+    if (game->ingame_buffer == 'e') {
+        send_to(PSTR("Wave: "), game->wave);
+        send_to(PSTR("Wave Asteroids: "), game->wave_info.asteroids);
+        send_to(PSTR("Wave Pending: "), game->spawn_pending);
+        send_to(PSTR("Wave Speed: "), game->wave_info.speed);
+        send_to(PSTR("Wave Pieces: "), game->wave_info.pieces);
+        send_to(PSTR("Wave Dropped: "), game->wave_dropped);
+    }
+}
+
+/**
+ *  send the input latency percentiles to computer, a percentile is the
+ *  upper end of the bucket it falls in
+ */
+void send_latency_report(){
+    static const uint8_t percentiles[] = {50, 90, 99};
+    send_to(PSTR("Latency samples: "), latency_samples);
+    if (latency_samples == 0) {
+        return;
+    }
+    for (uint8_t p = 0; p < sizeof(percentiles); p++) {
+        uint32_t rank = (uint32_t) latency_samples * percentiles[p] / 100;
+        uint32_t count = 0;
+        uint8_t bucket = 0;
+        while (bucket < LATENCY_BUCKETS - 1 && count + latency_histogram[bucket] <= rank) {
+            count += latency_histogram[bucket];
+            bucket++;
+        }
+        usb_serial_send_P(PSTR("p"));
+        send_num_to(percentiles[p]);
+        if (bucket == LATENCY_BUCKETS - 1) {
+            send_latency(PSTR(": over "), bucket * LATENCY_BUCKET_MS);
+        }else{
+            send_latency(PSTR(": under "), (bucket + 1) * LATENCY_BUCKET_MS);
+        }
+    }
+    send_latency(PSTR("max: "), latency_max);
+}
+
+/**
+ *  send how the RAM is used to computer, the stack is the most it has
+ *  ever used since the teensy was reset
+ */
+void send_ram_report(struct GameState * game){
+    if (game->ingame_buffer == 'c') {
+        send_to(PSTR("RAM .data: "), ram_data_size());
+        send_to(PSTR("RAM .bss: "), ram_bss_size());
+        send_to(PSTR("RAM game state: "), sizeof(*game));
+        send_to(PSTR("RAM heap: "), ram_heap_size());
+        send_to(PSTR("RAM stack peak: "), ram_stack_peak());
+        send_to(PSTR("RAM never used: "), ram_stack_unused());
+    }
+}
+
+/**
+ *  start measuring the input latency, or stop and send the report
+ */
+void latency_control(struct GameState * game){
+    if (game->ingame_buffer == 'z') {
+        if (isMeasuring) {
+            isMeasuring = false;
+            send_latency_report();
+        }else{
+            memset(latency_histogram, 0, sizeof(latency_histogram));
+            latency_samples = 0;
+            latency_max = 0;
+            latency_pending_count = 0;
+            isMeasuring = true;
+            usb_serial_send_P(PSTR("Latency Measuring\r\n"));
+        }
+    }
 }
 
 /**
  *  pause the game or unpause the game
  */
-void set_pause(){
-    if (BIT_IS_SET(PINB, 0) || ingame_buffer == 'p') {
-        isPasued = !isPasued;
-        ingame_buffer = 32;
-        if (isFirstStart) {
-            display_statues_computer();
-            isFirstStart = false;
-            usb_serial_send("Game Started\r\n");
+void set_pause(struct GameState * game){
+    if (BIT_IS_SET(game->frame_input.pressed, INPUT_CENTRE) || game->ingame_buffer == 'p') {
+        game->isPasued = !game->isPasued;
+        if (game->isFirstStart) {
+            display_statues_computer(game);
+            game->isFirstStart = false;
+            usb_serial_send_P(PSTR("Game Started\r\n"));
         }
     }
 }
 
+/**
+ *  move to another scene, from the next frame on, and set up what it
+ *  shows
+ *  Parameters:
+ *      game: the game
+ *      next: the scene
+ */
+void change_scene(struct GameState * game, enum Scene next){
+    scene = next;
+    scene_phase = 0;
+    scene_ticks = game->frame_input.ticks;
+    switch (next) {
+        case SCENE_INTRO:
+            backlight_set(BACKLIGHT_MAX, BACKLIGHT_LINEAR);
+            backlight_fade(0, FADE_RATE, BACKLIGHT_LINEAR);
+            intro_dashes[0] = (struct Animation){-1, 12, 1};
+            intro_dashes[1] = (struct Animation){LCD_X, 12, -1};
+            break;
+        case SCENE_PLAYING:
+        case SCENE_STATUS:
+            // the status screen and the game draw over each other
+            isHudDrawn = false;
+            break;
+        case SCENE_GAME_OVER:
+            backlight_set(0, BACKLIGHT_LINEAR);
+            backlight_fade(BACKLIGHT_MAX, FADE_RATE, BACKLIGHT_LINEAR);
+            display_statues_computer(game);
+            usb_serial_send_P(PSTR("Game Over\r\n"));
+            // the screen is timed by the game ticks, which stop while
+            // paused, and 'l' can end a paused game
+            game->isPasued = false;
+            break;
+        case SCENE_QUIT:
+            LCD_CMD(lcd_set_display_mode, lcd_display_inverse);
+            break;
+    }
+}
+
 /**
  *  determine which screen should the informations be sent to
  */
-void display_game_statues(){
+void display_game_statues(struct GameState * game){
     // if joystick down
-    if (BIT_IS_SET(PINB, 7) || ingame_buffer == 's') {
-        display_statues_computer();
-        if (isPasued) {
-            // joystick centre to escape
-            while (isPasued) {
-                display_statues_teensy();
-                if (BIT_IS_SET(PINB, 0) || usb_serial_getchar() == 'p') {
-                    break;
-                }
-            }
+    if (BIT_IS_SET(game->frame_input.pressed, INPUT_DOWN) || game->ingame_buffer == 's') {
+        display_statues_computer(game);
+        if (game->isPasued && scene == SCENE_PLAYING) {
+            change_scene(game, SCENE_STATUS);
         }
     }
 }
@@ -970,184 +1946,131 @@ bool isNumber(char c)
 }
 
 /**
- *  flash the leds
+ *  flash the led on the side most of the last group came down on, on and
+ *  off twice from the ticks it spawned at, so the frame is not held up
  */
-void led_warning(){
-    if (LED_side == 0) {
-        SET_BIT(PORTB, 2);
-        _delay_ms(50);
-        CLEAR_BIT(PORTB, 2);
-        _delay_ms(50);
-        SET_BIT(PORTB, 2);
-        _delay_ms(50);
+void led_warning(struct GameState * game){
+    if (game->LED_side == 0 || game->LED_side == 1) {
+        uint32_t step = (game->frame_input.ticks - game->led_ticks) / LED_FLASH_TICKS;
         CLEAR_BIT(PORTB, 2);
-        respawn_asteroid();
-    }else if (LED_side == 1){
-        SET_BIT(PORTB, 3);
-        _delay_ms(50);
         CLEAR_BIT(PORTB, 3);
-        _delay_ms(50);
-        SET_BIT(PORTB, 3);
-        _delay_ms(50);
-        CLEAR_BIT(PORTB, 3);
-        respawn_asteroid();
+        if (step == 0 || step == 2) {
+            SET_BIT(PORTB, game->LED_side == 0 ? 2 : 3);
+        }else if (step > 2){
+            game->LED_side = 4;
+        }
     }
-    LED_side = 4;
-    leftcounter = 0;
-    rightcounter = 0;
+    game->leftcounter = 0;
+    game->rightcounter = 0;
 }
 
 /**
  *  clean the buffer list of char
  */
-void clean_char_list(){
+void clean_char_list(struct GameState * game){
     for (int a = 0; a < 5; a++) {
-        list[a] = 0;
+        game->list[a] = 0;
     }
-    char_counter = 0;
+    game->char_counter = 0;
 }
 
 /**
  *  reset everything to default
  */
-void restart_game(bool directly){
-    if((BIT_IS_SET(PINF, 6) || ingame_buffer == 'r') || directly){
-        char_counter = 0;
-        shield_life = 5;
-        score = 0;
-        ship.x = 38;
-        asteroid_counter = 0;
-        boulder_counter = 0;
-        fragment_counter = 0;
-        plasma_counter = 0;
+void restart_game(struct GameState * game, bool directly){
+    if((BIT_IS_SET(game->frame_input.pressed, INPUT_SW2) || game->ingame_buffer == 'r') || directly){
+        game->char_counter = 0;
+        game->shield_life = 5;
+        game->score = 0;
+        game->ship.x = 38;
+        game->asteroid_counter = 0;
+        game->boulder_counter = 0;
+        game->fragment_counter = 0;
+        game->plasma_counter = 0;
         overflow_counter = 0;
-        plasma_timer = 0;
-        input = 0;
-        converted_number = 0;
-        speed = 1;
-        isPasued = true;
-        isFirstStart = true;
-        generated = false;
-        warned = false;
-        ingame_buffer = 32;
-        release_all_list();
-    }
-}
-
-/**
- *  quit the game and display student number only
- */
-void quit_game(){
-    LCD_CMD(lcd_set_display_mode, lcd_display_inverse);
-    while (1) {
-        draw_string(19, 19, "n10088652", FG_COLOUR);
-        show_screen();
-        clear_screen();
+        game->plasma_timer = 0;
+        game->input = 0;
+        game->converted_number = 0;
+        game->speed = 1;
+        game->wave = 0;
+        game->spawn_pending = 0;
+        particle_counter = 0;
+        game->isPasued = true;
+        game->isFirstStart = true;
+        game->generated = false;
+        game->warned = false;
+        release_all_list(game);
     }
 }
 
 /**
  *  if game is over
  */
-void game_over(){
-    if (shield_life <= 0) {
-        int temp_counter = 0;
-        display_statues_computer();
-        usb_serial_send("Game Over\r\n");
-        while (temp_counter <= 1023){
-            draw_string(15, 19, "Game Over", FG_COLOUR);
-            show_screen();
-            set_duty_cycle(temp_counter);
-            temp_counter += 15;
-            clear_screen();
-        }
-        double temp_timer = time;
-        while (time - temp_timer < 4) {
-            update_time();
-            SET_BIT(PORTB, 2);
-            SET_BIT(PORTB, 3);
-        }
-        CLEAR_BIT(PORTB, 2);
-        CLEAR_BIT(PORTB, 3);
-        while (1) {
-            set_duty_cycle(temp_counter);
-            if (temp_counter >= 15) {
-                temp_counter -= 15;
-            }
-            draw_string(5, 13, "LB: Restart", FG_COLOUR);
-            draw_string(5, 28, "RB: Quit", FG_COLOUR);
-            show_screen();
-            clear_screen();
-            if (BIT_IS_SET(PINF, 6) || usb_serial_getchar() == 'r') {
-                restart_game(true);
-                break;
-            }
-            else if (BIT_IS_SET(PINF, 5) || usb_serial_getchar() == 'q'){
-                quit_game();
-                break;
-            }
-        }
+void game_over(struct GameState * game){
+    if (game->shield_life <= 0 && scene == SCENE_PLAYING) {
+        change_scene(game, SCENE_GAME_OVER);
     }
 }
 
 /**
  *  reset the char buffer
  */
-void reset_char(){
-    clean_char_list();
-    char_code = 32;
+void reset_char(struct GameState * game){
+    clean_char_list(game);
+    game->char_code = 32;
 }
 
 /**
  *  if the letter 'l' is pressed
  */
-void l_isPressed(){
-    int buffer = atoi(list);
+void l_isPressed(struct GameState * game){
+    int buffer = atoi(game->list);
     if (buffer > 9999 || buffer < 0) {
         buffer = 9999;
     }
-    shield_life = buffer;
-    reset_char();
+    game->shield_life = buffer;
+    reset_char(game);
 }
 
 /**
  *  if the letter 'g' is pressed
  */
-void g_isPressed(){
-    int buffer = atoi(list);
+void g_isPressed(struct GameState * game){
+    int buffer = atoi(game->list);
     if (buffer > 9999 || buffer < 0) {
         buffer = 9999;
     }
-    score = buffer;
-    reset_char();
+    game->score = buffer;
+    reset_char(game);
 }
 
 /**
  *  if the letter 'j' is pressed
  */
-void j_isPressed(){
-    if (cheat_x < 0) {
-        cheat_x = atoi(list);
-        clean_char_list();
-    }else if (cheat_y < 0){
-        cheat_y = atoi(list);
-        if (asteroid_counter < 3) {
-            if(cheat_x >=0 && cheat_x < LCD_X - 6){
-                asteroid_list[asteroid_counter].x = cheat_x;
+void j_isPressed(struct GameState * game){
+    if (game->cheat_x < 0) {
+        game->cheat_x = atoi(game->list);
+        clean_char_list(game);
+    }else if (game->cheat_y < 0){
+        game->cheat_y = atoi(game->list);
+        if (game->asteroid_counter < MAX_ASTEROID) {
+            if(game->cheat_x >=0 && game->cheat_x < LCD_X - 6){
+                game->asteroid_list[game->asteroid_counter].x = game->cheat_x;
             }
-            if (cheat_y + 7 < SHIELD_Y) {
-                asteroid_list[asteroid_counter].y = cheat_y;
+            if (game->cheat_y + 7 < SHIELD_Y) {
+                game->asteroid_list[game->asteroid_counter].y = game->cheat_y;
             }
-            asteroid_counter++;
-            clean_char_list();
-            reset_char();
-            cheat_x = -1;
-            cheat_y = -1;
+            game->asteroid_frame[game->asteroid_counter] = 0;
+            game->asteroid_counter++;
+            clean_char_list(game);
+            reset_char(game);
+            game->cheat_x = -1;
+            game->cheat_y = -1;
         }else{
-            cheat_x = -1;
-            cheat_y = -1;
-            clean_char_list();
-            reset_char();
+            game->cheat_x = -1;
+            game->cheat_y = -1;
+            clean_char_list(game);
+            reset_char(game);
         }
     }
 }
@@ -1155,29 +2078,29 @@ void j_isPressed(){
 /**
  *  if the letter 'k' is pressed
  */
-void k_isPressed(){
-    if (cheat_x < 0) {
-        cheat_x = atoi(list);
-        clean_char_list();
-    }else if (cheat_y < 0){
-        cheat_y = atoi(list);
-        if (boulder_counter < 6) {
-            if (cheat_x >= 0 && cheat_x < LCD_X - 4) {
-                boulder_list[boulder_counter].x = cheat_x;
+void k_isPressed(struct GameState * game){
+    if (game->cheat_x < 0) {
+        game->cheat_x = atoi(game->list);
+        clean_char_list(game);
+    }else if (game->cheat_y < 0){
+        game->cheat_y = atoi(game->list);
+        if (game->boulder_counter < MAX_BOULDER) {
+            if (game->cheat_x >= 0 && game->cheat_x < LCD_X - 4) {
+                game->boulder_list[game->boulder_counter].x = game->cheat_x;
             }
-            if (cheat_y + 5 < SHIELD_Y) {
-                boulder_list[boulder_counter].y = cheat_y;
+            if (game->cheat_y + 5 < SHIELD_Y) {
+                game->boulder_list[game->boulder_counter].y = game->cheat_y;
             }
-            boulder_counter++;
-            clean_char_list();
-            reset_char();
-            cheat_x = -1;
-            cheat_y = -1;
+            game->boulder_counter++;
+            clean_char_list(game);
+            reset_char(game);
+            game->cheat_x = -1;
+            game->cheat_y = -1;
         }else{
-            cheat_x = -1;
-            cheat_y = -1;
-            clean_char_list();
-            reset_char();
+            game->cheat_x = -1;
+            game->cheat_y = -1;
+            clean_char_list(game);
+            reset_char(game);
         }
     }
 }
@@ -1185,25 +2108,25 @@ void k_isPressed(){
 /**
  *  if the letter 'i' is pressed
  */
-void i_isPressed(){
-    if (cheat_x < 0) {
-        cheat_x = atoi(list);
-        clean_char_list();
-    }else if (cheat_y < 0){
-        cheat_y = atoi(list);
-        if (fragment_counter < 12) {
-            fragment_list[fragment_counter].x = cheat_x;
-            fragment_list[fragment_counter].y = cheat_y;
-            fragment_counter++;
-            reset_char();
-            cheat_x = -1;
-            cheat_y = -1;
+void i_isPressed(struct GameState * game){
+    if (game->cheat_x < 0) {
+        game->cheat_x = atoi(game->list);
+        clean_char_list(game);
+    }else if (game->cheat_y < 0){
+        game->cheat_y = atoi(game->list);
+        if (game->fragment_counter < MAX_FRAGMENT) {
+            game->fragment_list[game->fragment_counter].x = game->cheat_x;
+            game->fragment_list[game->fragment_counter].y = game->cheat_y;
+            game->fragment_counter++;
+            reset_char(game);
+            game->cheat_x = -1;
+            game->cheat_y = -1;
         }
         else{
-            cheat_x = -1;
-            cheat_y = -1;
-            clean_char_list();
-            reset_char();
+            game->cheat_x = -1;
+            game->cheat_y = -1;
+            clean_char_list(game);
+            reset_char(game);
         }
     }
 }
@@ -1211,147 +2134,449 @@ void i_isPressed(){
 /**
  *  determine if the game is quit
  */
-void game_quit(){
-    if (ingame_buffer == 'q' || BIT_IS_SET(PINF, 5)){
-        quit_game();
+void game_quit(struct GameState * game){
+    if (game->ingame_buffer == 'q' || BIT_IS_SET(game->frame_input.pressed, INPUT_SW3)){
+        change_scene(game, SCENE_QUIT);
     }
 }
 
 /**
  *  send keyboard control commands to computer
  */
-void send_controls(){
-    if (ingame_buffer == '?') {
-        usb_serial_send("'a' move spaceship left\r\n"
-                        "'d' move spaceship right\r\n"
-                        "'w' fire plasma bolts\r\n"
-                        "'s' send and display game status\r\n"
-                        "'r' start/reset game\r\n"
-                        "'p' pause game\r\n"
-                        "'q' quit\r\n"
-                        "'t' set aim of the turret\r\n"
-                        "'m' set the speed of the game\r\n"
-                        "'l' set the remaining useful life of the deflector shield\r\n"
-                        "'g' set the score\r\n"
-                        "'?' print controls to computer screen (Putty)\r\n"
-                        "'h' move spaceship to coordinate\r\n"
-                        "'j' place asteroid at coordinate\r\n"
-                        "'k' place boulder at coordinate\r\n"
-                        "'i' place fragment at coordinate\r\n"
-                        " \r\n")
+void send_controls(struct GameState * game){
+    if (game->ingame_buffer == '?') {
+        usb_serial_send_P(PSTR("'a' move spaceship left\r\n"
+                               "'d' move spaceship right\r\n"
+                               "'w' fire plasma bolts\r\n"
+                               "'s' send and display game status\r\n"
+                               "'r' start/reset game\r\n"
+                               "'p' pause game\r\n"
+                               "'q' quit\r\n"
+                               "'t' set aim of the turret\r\n"
+                               "'m' set the speed of the game\r\n"
+                               "'l' set the remaining useful life of the deflector shield\r\n"
+                               "'g' set the score\r\n"
+                               "'?' print controls to computer screen (Putty)\r\n"
+                               "'h' move spaceship to coordinate\r\n"
+                               "'j' place asteroid at coordinate\r\n"
+                               "'k' place boulder at coordinate\r\n"
+                               "'i' place fragment at coordinate\r\n"
+                               "'v' start/stop recording inputs\r\n"
+                               "'y' replay recorded inputs\r\n"
+                               "'x' send the state of all objects and the screen\r\n"
+                               "'b' save the game to EEPROM and computer\r\n"
+                               "'n' load the game saved in EEPROM\r\n"
+                               "'u' load a game sent from computer\r\n"
+                               "'z' start/stop measuring input latency\r\n"
+                               "'c' send RAM usage\r\n"
+                               "'e' send the wave number and metrics\r\n"
+                               " \r\n"))
         ;
     }
-    ingame_buffer = 32;
 }
 
 /**
  *  if the letter 'h' is pressed
  */
-void h_isPressed(){
-    int buffer = atoi(list);
+void h_isPressed(struct GameState * game){
+    int buffer = atoi(game->list);
     if (buffer > LCD_X - 6) {
         buffer = LCD_X - 6;
     }else if (buffer < 0){
         buffer = 0;
     }
-    ship.x = buffer;
-    reset_char();
+    game->ship.x = buffer;
+    reset_char(game);
 }
 
 /**
  *  if the letter 'm' is pressed
  */
-void m_isPressed(){
-    m_timer = time;
-    double buffer = atoi(list);
+void m_isPressed(struct GameState * game){
+    game->m_timer = game->time;
+    double buffer = atoi(game->list);
     if (buffer > 1023) {
         buffer = 1023;
     }else if (buffer < 0){
         buffer = 0;
     }
-    speed = buffer / 1023;
-    reset_char();
+    game->speed = buffer / 1023;
+    reset_char(game);
 }
 
 /**
  *  if the letter 'o' is pressed
  */
-void o_isPressed(){
-    o_timer = time;
-    double buffer = atoi(list);
+void o_isPressed(struct GameState * game){
+    game->o_timer = game->time;
+    double buffer = atoi(game->list);
     if (buffer > 60) {
         buffer = 60;
     }
-    if (isNegative) {
-        leftpotent = -buffer;
+    if (game->isNegative) {
+        game->leftpotent = -buffer;
     }else{
-        leftpotent = buffer;
+        game->leftpotent = buffer;
     }
-    isNegative = false;
-    reset_char();
+    game->isNegative = false;
+    reset_char(game);
 }
 
 /**
  *  determine which letter is pressed and call the function
  */
-void game_cheat_with_number(){
-    switch (char_code) {
+void game_cheat_with_number(struct GameState * game){
+    switch (game->char_code) {
         case 'm':
-            m_isPressed();
+            m_isPressed(game);
             break;
         case 'o':
-            o_isPressed();
+            o_isPressed(game);
             break;
         case 'l':
-            l_isPressed();
+            l_isPressed(game);
             break;
         case 'g':
-            g_isPressed();
+            g_isPressed(game);
             break;
         case 'h':
-            h_isPressed();
+            h_isPressed(game);
             break;
         case 'j':
-            j_isPressed();
+            j_isPressed(game);
             break;
         case 'k':
-            k_isPressed();
+            k_isPressed(game);
             break;
         case 'i':
-            i_isPressed();
+            i_isPressed(game);
             break;
     }
 }
 
 /**
- *  get the acceptable letter from computer and store them into varibles
+ *  store one acceptable letter from computer into varibles
  */
-void get_command(){
-    char_buffer = usb_serial_getchar();
-    if (isNumber(char_buffer) && char_code != 32 && char_code != 0 && accept_char(char_code)) {
-        list[char_counter] = char_buffer;
-        char_counter++;
-    }else if((accept_char(char_buffer) && (char_code == 32 || char_code == 0))){
-        char_code = char_buffer;
-    }else if(ingame_char(char_buffer)){
-        ingame_buffer = char_buffer;
+void take_command(struct GameState * game, char c){
+    game->char_buffer = c;
+    if (isNumber(game->char_buffer) && game->char_code != 32 && game->char_code != 0 && accept_char(game->char_code)) {
+        game->list[game->char_counter] = game->char_buffer;
+        game->char_counter++;
+    }else if((accept_char(game->char_buffer) && (game->char_code == 32 || game->char_code == 0))){
+        game->char_code = game->char_buffer;
+    }else if(ingame_char(game->char_buffer)){
+        game->ingame_buffer = game->char_buffer;
     }
-    if (char_buffer == '-' && char_code == 'o') {
-        isNegative = true;
+    if (game->char_buffer == '-' && game->char_code == 'o') {
+        game->isNegative = true;
     }
-    if (char_buffer == 0x0D){
-        game_cheat_with_number();
+    if (game->char_buffer == 0x0D){
+        game_cheat_with_number(game);
+    }
+}
+
+/**
+ *  take every char received in this frame, ingame_buffer holds the last
+ *  in game command of this frame only
+ */
+void get_command(struct GameState * game){
+    game->ingame_buffer = 32;
+    game->char_buffer = -1;
+    for (uint8_t a = 0; a < game->frame_input.received_count; a++) {
+        take_command(game, game->frame_input.received[a]);
     }
 }
 
 /**
  *  set the speed of the game by using the right pot
  */
-void setSpeed(){
-    if (m_timer == -1 || time - m_timer > 1) {
-        double a = adc_read(1);
-        speed = a / 1023;
-        m_timer = -1;
+void setSpeed(struct GameState * game){
+    if (game->m_timer == -1 || game->time - game->m_timer > 1) {
+        double a = game->frame_input.right_adc;
+        game->speed = a / 1023;
+        game->m_timer = -1;
+    }
+}
+
+///===============================================================
+//                       Input recording
+///===============================================================
+
+/**
+ *  put everything a recorded session depends on into a known state
+ *  Parameters:
+ *      game: the game
+ *      seed: the seed of the random numbers
+ */
+void start_session(struct GameState * game, uint16_t seed){
+    srand(seed);
+    init_game(game);
+    reset_particles();
+    reset_hud();
+    latency_pending_count = 0;
+    overflow_counter = 0;
+    clear_screen();
+    change_scene(game, SCENE_PLAYING);
+}
+
+/**
+ *  start the recorded session requested in the last frame
+ */
+void start_pending_session(struct GameState * game){
+    if (isSessionPending) {
+        start_session(game, session_seed);
+        isSessionPending = false;
+        if (isRecording) {
+            usb_serial_send_P(PSTR("#S"));
+            usb_serial_send_hex((uint8_t *) &session_seed, sizeof(session_seed));
+            usb_serial_send_P(PSTR("\r\n"));
+        }
+    }
+}
+
+/**
+ *  start or stop sending the inputs of every frame to computer
+ */
+void toggle_recording(struct GameState * game){
+    if (isRecording) {
+        isRecording = false;
+        usb_serial_send_P(PSTR("#E\r\n"));
+    }else{
+        session_seed = read_ticks() ^ game->frame_input.left_adc ^ (game->frame_input.right_adc << 6);
+        isSessionPending = true;
+        isRecording = true;
+    }
+}
+
+/**
+ *  wait for a recording from computer and replay it instead of the hardware
+ */
+void start_replay(){
+    char c;
+    do {
+        while (usb_serial_wait_char() != '#') {}
+        c = usb_serial_wait_char();
+    } while (c != 'S');
+    usb_serial_read_hex((uint8_t *) &session_seed, sizeof(session_seed));
+    isSessionPending = true;
+    isRecording = false;
+    isReplaying = true;
+}
+
+/**
+ *  determine if the recorder is used
+ */
+void recorder_control(struct GameState * game){
+    if (isReplaying) {
+        return;
+    }
+    if (game->ingame_buffer == 'v') {
+        toggle_recording(game);
+    }else if (game->ingame_buffer == 'y'){
+        start_replay();
+    }
+}
+
+///===============================================================
+//                       Snapshots
+///===============================================================
+
+// where a snapshot is saved to or loaded from
+enum SnapshotTarget{
+    SNAPSHOT_EEPROM,
+    SNAPSHOT_USB
+};
+
+/**
+ *  save a block of a snapshot
+ *  Parameters:
+ *      target: where the snapshot goes
+ *      offset: the offset of the block in the snapshot, moved past it
+ *      data: the block
+ *      length: the number of bytes in the block
+ */
+void save_block(enum SnapshotTarget target, uint16_t * offset, void * data, uint16_t length){
+    if (target == SNAPSHOT_EEPROM) {
+        eeprom_update_block(data, (void *) (uintptr_t) (SNAPSHOT_ADDRESS + *offset), length);
+    }else{
+        usb_serial_send_hex(data, length);
+    }
+    *offset += length;
+}
+
+/**
+ *  load a block of a snapshot
+ *  Parameters:
+ *      target: where the snapshot comes from
+ *      offset: the offset of the block in the snapshot, moved past it
+ *      data: where the block is loaded to
+ *      length: the number of bytes in the block
+ */
+void load_block(enum SnapshotTarget target, uint16_t * offset, void * data, uint16_t length){
+    if (target == SNAPSHOT_EEPROM) {
+        eeprom_read_block(data, (void *) (uintptr_t) (SNAPSHOT_ADDRESS + *offset), length);
+    }else{
+        usb_serial_read_hex(data, length);
+    }
+    *offset += length;
+}
+
+/**
+ *  add a block to the checksum of a snapshot
+ *  Parameters:
+ *      check: the checksum so far
+ *      data: the block
+ *      length: the number of bytes in the block
+ *
+ *  return: the checksum with the block added
+ */
+uint16_t snapshot_checksum(uint16_t check, const void * data, uint16_t length){
+    const uint8_t * bytes = data;
+    for (uint16_t i = 0; i < length; i++) {
+        check = _crc16_update(check, bytes[i]);
+    }
+    return check;
+}
+
+/**
+ *  save the game, only the used part of the object lists is saved
+ *  Parameters:
+ *      game: the game
+ *      target: where the snapshot goes
+ *
+ *  return: weather the snapshot fits in the target
+ */
+bool save_game(struct GameState * game, enum SnapshotTarget target){
+    uint16_t offset = 0;
+    uint16_t layout = offsetof(struct GameState, plasma_list);
+    uint8_t magic = SNAPSHOT_MAGIC;
+    uint8_t version = SNAPSHOT_VERSION;
+    uint16_t check = 0xFFFF;
+    uint16_t size = sizeof(magic) + sizeof(version) + sizeof(layout) + sizeof(check) + layout
+        + (game->plasma_counter + game->asteroid_counter + game->boulder_counter + game->fragment_counter) * sizeof(struct Object);
+    if (target == SNAPSHOT_EEPROM && SNAPSHOT_ADDRESS + size > E2END + 1) {
+        return false;
+    }
+    check = snapshot_checksum(check, game, layout);
+    check = snapshot_checksum(check, game->plasma_list, game->plasma_counter * sizeof(struct Object));
+    check = snapshot_checksum(check, game->asteroid_list, game->asteroid_counter * sizeof(struct Object));
+    check = snapshot_checksum(check, game->boulder_list, game->boulder_counter * sizeof(struct Object));
+    check = snapshot_checksum(check, game->fragment_list, game->fragment_counter * sizeof(struct Object));
+    save_block(target, &offset, &magic, sizeof(magic));
+    save_block(target, &offset, &version, sizeof(version));
+    save_block(target, &offset, &layout, sizeof(layout));
+    save_block(target, &offset, &check, sizeof(check));
+    save_block(target, &offset, game, layout);
+    save_block(target, &offset, game->plasma_list, game->plasma_counter * sizeof(struct Object));
+    save_block(target, &offset, game->asteroid_list, game->asteroid_counter * sizeof(struct Object));
+    save_block(target, &offset, game->boulder_list, game->boulder_counter * sizeof(struct Object));
+    save_block(target, &offset, game->fragment_list, game->fragment_counter * sizeof(struct Object));
+    return true;
+}
+
+// the most objects each list can load, in the order of the list counters
+const uint8_t snapshot_limits[4] PROGMEM = {MAX_PLASMA, MAX_ASTEROID, MAX_BOULDER, MAX_FRAGMENT};
+
+/**
+ *  load a game saved by save_game and carry on from where it was saved.
+ *  the saved values are loaded and checked on their own first, a snapshot
+ *  refused then leaves the game as it was.
+ *  over usb the snapshot can only be read once and there is no ram for a
+ *  second copy of the object lists, so they are read into the game before
+ *  their checksum is known. a bad checksum there restarts the game, so it
+ *  never carries on with objects that were not saved with it.
+ *  Parameters:
+ *      game: the game
+ *      target: where the snapshot comes from
+ *
+ *  return: weather a valid snapshot was loaded
+ */
+bool load_game(struct GameState * game, enum SnapshotTarget target){
+    uint16_t offset = 0;
+    uint16_t layout, check;
+    uint8_t magic, version;
+    uint8_t saved[offsetof(struct GameState, plasma_list)];
+    int counters[4];
+    uint16_t lists = 0;
+    load_block(target, &offset, &magic, sizeof(magic));
+    load_block(target, &offset, &version, sizeof(version));
+    load_block(target, &offset, &layout, sizeof(layout));
+    load_block(target, &offset, &check, sizeof(check));
+    if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION || layout != sizeof(saved)) {
+        return false;
+    }
+    load_block(target, &offset, saved, layout);
+    memcpy(counters, saved + offsetof(struct GameState, plasma_counter), sizeof(counters));
+    for (uint8_t i = 0; i < 4; i++) {
+        if (counters[i] < 0 || counters[i] > pgm_read_byte(&snapshot_limits[i])) {
+            return false;
+        }
+        lists += counters[i] * sizeof(struct Object);
+    }
+    // the frames index asteroid_frames in flash when they are drawn
+    for (uint8_t i = 0; i < MAX_ASTEROID; i++) {
+        if (saved[offsetof(struct GameState, asteroid_frame) + i] >= SPRITE_FRAMES) {
+            return false;
+        }
+    }
+    uint16_t sum = snapshot_checksum(0xFFFF, saved, layout);
+    if (target == SNAPSHOT_EEPROM) {
+        // the lists can be read twice here, check them before loading them
+        for (uint16_t i = 0; i < lists; i++) {
+            sum = _crc16_update(sum, eeprom_read_byte((uint8_t *) (uintptr_t) (SNAPSHOT_ADDRESS + offset + i)));
+        }
+        if (sum != check) {
+            return false;
+        }
+    }
+    load_block(target, &offset, game->plasma_list, counters[0] * sizeof(struct Object));
+    load_block(target, &offset, game->asteroid_list, counters[1] * sizeof(struct Object));
+    load_block(target, &offset, game->boulder_list, counters[2] * sizeof(struct Object));
+    load_block(target, &offset, game->fragment_list, counters[3] * sizeof(struct Object));
+    if (target == SNAPSHOT_USB) {
+        sum = snapshot_checksum(sum, game->plasma_list, counters[0] * sizeof(struct Object));
+        sum = snapshot_checksum(sum, game->asteroid_list, counters[1] * sizeof(struct Object));
+        sum = snapshot_checksum(sum, game->boulder_list, counters[2] * sizeof(struct Object));
+        sum = snapshot_checksum(sum, game->fragment_list, counters[3] * sizeof(struct Object));
+        if (sum != check) {
+            restart_game(game, true);
+            return false;
+        }
+    }
+    memcpy(game, saved, layout);
+    // the game time carries on from the saved ticks
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        overflow_counter = game->frame_input.ticks >> 8;
+    }
+    return true;
+}
+
+/**
+ *  determine if the game is saved or loaded
+ */
+void snapshot_control(struct GameState * game){
+    if (game->ingame_buffer == 'b') {
+        if (save_game(game, SNAPSHOT_EEPROM)) {
+            usb_serial_send_P(PSTR("Game Saved\r\n"));
+        }else{
+            usb_serial_send_P(PSTR("Game Too Big For EEPROM\r\n"));
+        }
+        usb_serial_send_P(PSTR("#G"));
+        save_game(game, SNAPSHOT_USB);
+        usb_serial_send_P(PSTR("\r\n"));
+    }else if (game->ingame_buffer == 'n' || game->ingame_buffer == 'u'){
+        bool loaded;
+        if (game->ingame_buffer == 'n') {
+            loaded = load_game(game, SNAPSHOT_EEPROM);
+        }else{
+            char c;
+            do {
+                while (usb_serial_wait_char() != '#') {}
+                c = usb_serial_wait_char();
+            } while (c != 'G');
+            loaded = load_game(game, SNAPSHOT_USB);
+        }
+        usb_serial_send_P(loaded ? PSTR("Game Loaded\r\n") : PSTR("No Saved Game\r\n"));
     }
 }
 
@@ -1362,54 +2587,189 @@ void setSpeed(){
 /**
  *  loop functions
  */
-void do_all(){
-    set_pause();
-    led_warning();
-    respawn_asteroid();
-    game_quit();
-    display_game_statues();
-    set_cannon_angle();
-    update_asteroid();
-    fire_cannon();
-    update_spaceship();
-    update_plasmas();
-    release_plasma_list();
-    update_boulders();
-    release_boulder_list();
-    update_fragments();
-    release_fragment_list();
-    release_asteroid_list();
+void do_all(struct GameState * game){
+    set_pause(game);
+    led_warning(game);
+    respawn_asteroid(game);
+    spawn_queued_asteroids(game);
+    game_quit(game);
+    display_game_statues(game);
+    set_cannon_angle(game);
+    update_asteroid(game);
+    fire_cannon(game);
+    update_spaceship(game);
+    update_plasmas(game);
+    release_plasma_list(game);
+    update_boulders(game);
+    release_boulder_list(game);
+    update_fragments(game);
+    release_fragment_list(game);
+    release_asteroid_list(game);
+    update_particles(game);
     draw_shield();
-    draw_spaceship();
-    game_over();
-    send_controls();
-    get_command();
-    setSpeed();
+    draw_spaceship(game);
+    game_over(game);
+    recorder_control(game);
+    snapshot_control(game);
+    setSpeed(game);
 }
 
 /**
  *  setup when the game is initialed
  */
-void setup_canvas(){
-    spawn_asteroid();
-    set_duty_cycle(0);
+void setup_canvas(struct GameState * game){
+    start_wave(game);
+    spawn_queued_asteroids(game);
+    backlight_set(0, BACKLIGHT_LINEAR);
+}
+
+///===============================================================
+//                            Scenes
+///===============================================================
+
+/**
+ *  one frame of the game
+ */
+void play_scene(struct GameState * game){
+    update_time(game);
+    // only the parts drawn last frame need clearing
+    clear_dirty();
+    collision_detection(game);
+    do_all(game);
+    restart_game(game, false);
+    show_frame();
+}
+
+/**
+ *  one frame of the intro, the left button or 'r' starts the game
+ */
+void intro_scene(struct GameState * game){
+    display_introduction();
+    if (BIT_IS_SET(game->frame_input.pressed, INPUT_SW2) || received_char(game, 'r')) {
+        clear_screen();
+        setup_canvas(game);
+        change_scene(game, SCENE_PLAYING);
+    }
+}
+
+/**
+ *  one frame of the status screen, joystick centre or 'p' goes back to
+ *  the paused game
+ */
+void status_scene(struct GameState * game){
+    display_statues_teensy(game);
+    if (BIT_IS_SET(game->frame_input.pressed, INPUT_CENTRE) || received_char(game, 'p')) {
+        clear_screen();
+        change_scene(game, SCENE_PLAYING);
+    }
+}
+
+/**
+ *  one frame of the game over screen. the backlight fades in, the LEDs
+ *  light for 4 seconds, then it fades out while the screen waits for the left button or 'r' to
+ *  restart or the right button or 'q' to quit
+ */
+void game_over_scene(struct GameState * game){
+    clear_screen();
+    if (scene_phase == 0) {
+        draw_string_P(15, 19, PSTR("Game Over"), FG_COLOUR);
+        // the backlight fades in meanwhile
+        if (game->frame_input.ticks - scene_ticks >= FADE_TICKS) {
+            scene_phase = 1;
+            scene_ticks = game->frame_input.ticks;
+        }
+    }else if (scene_phase == 1){
+        draw_string_P(15, 19, PSTR("Game Over"), FG_COLOUR);
+        SET_BIT(PORTB, 2);
+        SET_BIT(PORTB, 3);
+        if ((game->frame_input.ticks - scene_ticks) * PRESCALE / FREQ >= 4) {
+            CLEAR_BIT(PORTB, 2);
+            CLEAR_BIT(PORTB, 3);
+            backlight_fade(0, FADE_RATE, BACKLIGHT_LINEAR);
+            scene_phase = 2;
+        }
+    }else{
+        draw_string_P(5, 13, PSTR("LB: Restart"), FG_COLOUR);
+        draw_string_P(5, 28, PSTR("RB: Quit"), FG_COLOUR);
+        if (BIT_IS_SET(game->frame_input.pressed, INPUT_SW2) || received_char(game, 'r')) {
+            restart_game(game, true);
+            clear_screen();
+            change_scene(game, SCENE_PLAYING);
+            return;
+        }else if (BIT_IS_SET(game->frame_input.pressed, INPUT_SW3) || received_char(game, 'q')){
+            change_scene(game, SCENE_QUIT);
+        }
+    }
+    show_frame();
+}
+
+/**
+ *  one frame of the quit screen, the student number only
+ */
+void quit_scene(struct GameState * game){
+    clear_screen();
+    draw_string_P(19, 19, PSTR("n10088652"), FG_COLOUR);
+    show_frame();
+}
+
+/**
+ *  the serial commands that report on the game, answered in every scene
+ */
+void scene_services(struct GameState * game){
+    request_state(game);
+    latency_control(game);
+    send_ram_report(game);
+    send_wave(game);
+    send_controls(game);
+}
+
+/**
+ *  set up the teensy and show the intro
+ */
+void start_up(struct GameState * game){
+    init_game(game);
+    setup_bit();
+    change_scene(game, SCENE_INTRO);
+}
+
+/**
+ *  one frame of whichever scene is shown, see tools/host for the
+ *  computer build that runs it without a teensy
+ */
+void run_frame(struct GameState * game){
+    start_pending_session(game);
+    sample_inputs(game);
+    get_command(game);
+    switch (scene) {
+        case SCENE_INTRO:
+            intro_scene(game);
+            break;
+        case SCENE_PLAYING:
+            play_scene(game);
+            break;
+        case SCENE_STATUS:
+            status_scene(game);
+            break;
+        case SCENE_GAME_OVER:
+            game_over_scene(game);
+            break;
+        case SCENE_QUIT:
+            quit_scene(game);
+            break;
+    }
+    scene_services(game);
+    send_requested_state(game);
+    _delay_ms(50);
 }
 
 /**
  *  main function
  */
 int main(int argc, const char * argv[]) {
-    setup_bit();
-    display_introduction();
-    setup_canvas();
+    struct GameState * game = &game_state;
+    start_up(game);
     for ( ;; ) {
-        update_time();
-        clear_screen();
-        collision_detection();
-        do_all();
-        restart_game(false);
-        show_screen();
-        _delay_ms(50);
+        run_frame(game);
     }
     return 0;
 }
@@ -13,17 +13,107 @@
 #define SHIELD_Y 39
 #define POTENTIOMETER_MAX 1023
 #define PLASMA_LENGTH 2
-#define MAX_PLASMA 50
+// pixels a plasma bolt moves each frame, hits are swept along the way
+#ifndef PLASMA_SPEED
+#define PLASMA_SPEED PLASMA_LENGTH
+#endif
 #define VANISH 999
-#define MAX_ASTEROID 3
-#define MAX_BOULDER 6
-#define MAX_FRAGMENT 12
 #define SHIELD_LIFE 5
 #define FREQ     (8000000.0)
 #define PRESCALE (1024.0)
 
 #define BIT(x) (1 << (x))
-#define OVERFLOW_TOP (1023)
+
+// timer0 ticks between asteroid rotation frames, 8 frames a second
+#define ASTEROID_SPIN_TICKS ((uint16_t) (FREQ / PRESCALE / 8))
+
+// timer0 ticks the warning leds are on or off for, 50ms
+#define LED_FLASH_TICKS ((uint16_t) (FREQ / PRESCALE / 20))
+
+// backlight levels a second the intro and game over screens fade at
+#define FADE_RATE 300
+// timer0 ticks a fade across the whole backlight range takes. game over
+// waits this long on the recorded ticks, the backlight interrupt only
+// drives the PWM and replays do not depend on it
+#define FADE_TICKS ((uint32_t) (FREQ / PRESCALE * BACKLIGHT_MAX / FADE_RATE))
 #define ADC_MAX (1023)
 
+// Most asteroids spawned side by side at once, up to 11 fit across the
+// screen, and the asteroids each wave after the last in the table adds
+#ifndef SPAWN_GROUP_MAX
+#define SPAWN_GROUP_MAX 3
+#endif
+#define WAVE_GROWTH 2
+
+// Entity capacities. Build with -DCAPACITY_PROFILE=CAPACITY_INTENSE for the
+// high-intensity mode, or override any single MAX_ with -D.
+#define CAPACITY_STANDARD 0
+#define CAPACITY_INTENSE 1
+#ifndef CAPACITY_PROFILE
+#define CAPACITY_PROFILE CAPACITY_STANDARD
+#endif
+
+#if CAPACITY_PROFILE == CAPACITY_INTENSE
+#ifndef MAX_PLASMA
+#define MAX_PLASMA 30
+#endif
+#ifndef MAX_BOULDER
+#define MAX_BOULDER 24
+#endif
+#ifndef MAX_FRAGMENT
+#define MAX_FRAGMENT 48
+#endif
+#endif
+
+#ifndef MAX_PLASMA
+#define MAX_PLASMA 50
+#endif
+#ifndef MAX_ASTEROID
+#define MAX_ASTEROID SPAWN_GROUP_MAX
+#endif
+#ifndef MAX_BOULDER
+#define MAX_BOULDER 6
+#endif
+#ifndef MAX_FRAGMENT
+#define MAX_FRAGMENT 12
+#endif
+
+// Explosion particles: the pool, the most that may start in one frame and
+// how many frames one lives
+#ifndef MAX_PARTICLE
+#define MAX_PARTICLE 24
+#endif
+#define PARTICLE_BUDGET 12
+#define PARTICLE_LIFE 8
+
+// RAM of the ATmega32u4, and the part of it kept free of the game's own
+// variables for the stack and the variables of the libraries
+#define RAM_SIZE 2560
+#ifndef STACK_RESERVE
+#define STACK_RESERVE 256
+#endif
+
+// Set to 1 to draw the targets into a bitmap of owner ids once a frame,
+// so each plasma is only tested against the targets on its way. Costs
+// LCD_BUFFER_SIZE bytes of RAM
+#ifndef COLLISION_BITMAP
+#define COLLISION_BITMAP 0
+#endif
+
+// Most chars from computer taken in one frame, the rest stay in the
+// input queue for the next frame
+#define FRAME_CHARS 4
+
+// Game snapshots
+#define SNAPSHOT_ADDRESS 0
+#define SNAPSHOT_MAGIC 'G'
+// Bump when the snapshot layout changes, older snapshots are then refused
+#define SNAPSHOT_VERSION 4
+
+// Input latency measurement, in buckets of LATENCY_BUCKET_MS, the last
+// bucket counts everything slower
+#define LATENCY_BUCKET_MS 8
+#define LATENCY_BUCKETS 33
+#define LATENCY_PENDING 8
+
 
@@ -0,0 +1,267 @@
+/*
+ *	batch_sim.c
+ *
+ *	Host tool for balancing: plays thousands of games with a scripted or
+ *	random player and reports games per second and the spread of scores
+ *	and survival times.
+ *
+ *		make batch
+ *		./tools/batch_sim [games] [seconds] [aim|random] [speed %] [jobs]
+ *
+ *	The speed is the right pot as a percent, 100 is the fastest.
+ *
+ *	Every game is main.c itself, run on the simulated board (host/board.h)
+ *	as "make check" runs it, so the waves, the splitting, the hit tests
+ *	and the shield are the game's own. Each game starts as a recorded
+ *	session does, from start_session with the game number as its seed,
+ *	and is unpaused with 'p'. The player then only uses the hardware: the
+ *	left pot aims, joystick up fires and joystick left and right steer
+ *	the ship. The aiming player points at the lowest object and steers
+ *	under it, the random one wanders and fires half the time.
+ *
+ *	The game keeps its state in globals, so one process plays one game at
+ *	a time. Up to jobs processes (the number of CPUs by default) each play
+ *	every jobs-th game and write the results to memory they all share.
+ */
+#define main teensy_main
+#include "../main.c"
+#undef main
+
+#include <math.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "board.h"
+
+#define FRAMES_PER_SECOND 20
+
+/*
+ *  Frames a game may be paused for, on top of its seconds, before it is
+ *	given up on.
+ */
+#define SLACK_FRAMES (10 * FRAMES_PER_SECOND)
+
+/*
+ *  How one game ended.
+ */
+struct result {
+	int score;
+	double survived;
+	bool over;
+};
+
+static int game_count;
+static int seconds;
+static bool aiming;
+static int speed_percent;
+static struct result *results;
+
+/*
+ *  The player's own random numbers, so it does not change the game's.
+ */
+static uint32_t player_random;
+
+static uint32_t next_random(void) {
+	player_random ^= player_random << 13;
+	player_random ^= player_random >> 17;
+	player_random ^= player_random << 5;
+	return player_random;
+}
+
+/*
+ *  Turn the left pot so the cannon points at angle degrees.
+ */
+static void aim_cannon(double angle) {
+	long adc = lround((angle + 60) * 8.5);
+
+	board_set_pot(0, adc < 0 ? 0 : adc > 1023 ? 1023 : adc);
+}
+
+/*
+ *  Tap the joystick towards the way the ship should go, as in
+ *	update_spaceship: 0 is right, 1 is left and 2 is standing still. A tap
+ *	is held for a frame and let go the next.
+ */
+static void steer(struct GameState *game, int way) {
+	static bool tapped;
+
+	board_set_input(INPUT_LEFT, false);
+	board_set_input(INPUT_RIGHT, false);
+	if ( tapped || way == game->ship_angle ) {
+		tapped = false;
+		return;
+	}
+
+	bool left = way == 1 || (way == 2 && game->ship_angle == 0);
+
+	board_set_input(left ? INPUT_LEFT : INPUT_RIGHT, true);
+	tapped = true;
+}
+
+/*
+ *  Find the lowest object of a list on the screen.
+ */
+static void lowest(struct Object objects[], int count, int size, double *x, double *y) {
+	for ( int i = 0; i < count; i++ ) {
+		struct Object *o = &objects[i];
+
+		if ( o->x >= 0 && o->x < LCD_X && o->y > -size && o->y + size / 2.0 > *y ) {
+			*x = o->x + size / 2.0;
+			*y = o->y + size / 2.0;
+		}
+	}
+}
+
+/*
+ *  Set the inputs for the next frame.
+ */
+static void play(struct GameState *game) {
+	if ( aiming ) {
+		double x = 0, y = -LCD_Y;
+
+		lowest(game->asteroid_list, game->asteroid_counter, 7, &x, &y);
+		lowest(game->boulder_list, game->boulder_counter, 5, &x, &y);
+		lowest(game->fragment_list, game->fragment_counter, 3, &x, &y);
+
+		bool seen = y > -LCD_Y;
+		double pivot = game->ship.x + 2;
+
+		if ( seen ) {
+			aim_cannon(atan2(x - pivot, game->ship.y - y) * 180 / M_PI);
+		}
+		steer(game, !seen || fabs(x - pivot) < 8 ? 2 : x < pivot ? 1 : 0);
+		board_set_input(INPUT_UP, seen);
+	}
+	else {
+		aim_cannon(game->leftpotent + (int) (next_random() % 11) - 5);
+		steer(game, next_random() % 20 == 0 ? next_random() % 3 : game->ship_angle);
+		board_set_input(INPUT_UP, next_random() & 1);
+	}
+}
+
+/*
+ *  Play game number g to its end or its seconds.
+ */
+static void play_game(int g) {
+	struct GameState *game = &game_state;
+	int frames = seconds * FRAMES_PER_SECOND + SLACK_FRAMES;
+
+	player_random = 2463534242u ^ (uint32_t) g * 2654435761u;
+	board_set_pot(0, 512);
+	board_set_pot(1, speed_percent * 1023 / 100);
+	start_session(game, g);
+	board_send("p", 1);
+
+	for ( int f = 0; f < frames && scene == SCENE_PLAYING && game->time < seconds; f++ ) {
+		run_frame(game);
+		play(game);
+	}
+
+	results[g].score = game->score;
+	results[g].survived = game->time < seconds ? game->time : seconds;
+	results[g].over = scene != SCENE_PLAYING;
+}
+
+/*
+ *  Play every jobs-th game from first, in a process of its own.
+ */
+static void worker(int first, int jobs) {
+	board_reset();
+	board_serial = NULL;
+	start_up(&game_state);
+
+	for ( int g = first; g < game_count; g += jobs ) {
+		play_game(g);
+	}
+}
+
+static int compare_int(const void *a, const void *b) {
+	return *(const int *) a - *(const int *) b;
+}
+
+static int compare_double(const void *a, const void *b) {
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[]) {
+	int jobs = argc > 5 ? atoi(argv[5]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+	struct timespec start, end;
+
+	game_count = argc > 1 ? atoi(argv[1]) : 1000;
+	seconds = argc > 2 ? atoi(argv[2]) : 300;
+	aiming = argc <= 3 || strcmp(argv[3], "random") != 0;
+	speed_percent = argc > 4 ? atoi(argv[4]) : 100;
+	if ( game_count <= 0 || seconds <= 0 || speed_percent <= 0 || speed_percent > 100 || jobs <= 0 ) {
+		fprintf(stderr, "usage: %s [games] [seconds] [aim|random] [speed %%] [jobs]\n", argv[0]);
+		return 2;
+	}
+	if ( jobs > game_count ) {
+		jobs = game_count;
+	}
+
+	results = mmap(NULL, game_count * sizeof(*results), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if ( results == MAP_FAILED ) {
+		perror("mmap");
+		return 2;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int j = 0; j < jobs; j++ ) {
+		pid_t pid = fork();
+
+		if ( pid == 0 ) {
+			worker(j, jobs);
+			_exit(0);
+		}
+		if ( pid < 0 ) {
+			perror("fork");
+			return 2;
+		}
+	}
+
+	int status, failed = 0;
+	while ( wait(&status) > 0 ) {
+		failed += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+	}
+	if ( failed > 0 ) {
+		fprintf(stderr, "%d of %d jobs stopped before their games were played\n", failed, jobs);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	double score_total = 0, survival_total = 0;
+	int survivors = 0;
+	int *scores = malloc(game_count * sizeof(*scores));
+	double *survivals = malloc(game_count * sizeof(*survivals));
+
+	for ( int g = 0; g < game_count; g++ ) {
+		scores[g] = results[g].score;
+		survivals[g] = results[g].survived;
+		score_total += scores[g];
+		survival_total += survivals[g];
+		survivors += !results[g].over;
+	}
+	qsort(scores, game_count, sizeof(*scores), compare_int);
+	qsort(survivals, game_count, sizeof(*survivals), compare_double);
+
+	printf("games: %d, %s player, speed %d%%, up to %d s each, %d jobs\n", game_count,
+		aiming ? "aiming" : "random", speed_percent, seconds, jobs);
+	printf("games per second: %.1f\n", game_count / elapsed);
+	printf("score: mean %.1f, min %d, p10 %d, p50 %d, p90 %d, max %d\n",
+		score_total / game_count, scores[0], scores[game_count / 10], scores[game_count / 2],
+		scores[game_count * 9 / 10], scores[game_count - 1]);
+	printf("survival s: mean %.1f, min %.1f, p10 %.1f, p50 %.1f, p90 %.1f, max %.1f\n",
+		survival_total / game_count, survivals[0], survivals[game_count / 10],
+		survivals[game_count / 2], survivals[game_count * 9 / 10], survivals[game_count - 1]);
+	printf("still alive at the limit: %d\n", survivors);
+
+	free(scores);
+	free(survivals);
+	munmap(results, game_count * sizeof(*results));
+	return 0;
+}
@@ -0,0 +1,14 @@
+/*
+ *	avr/eeprom.h for the host build, the EEPROM is an array in board.c.
+ */
+#ifndef HOST_AVR_EEPROM_H_
+#define HOST_AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint8_t eeprom_read_byte(const uint8_t *address);
+void eeprom_read_block(void *data, const void *address, size_t length);
+void eeprom_update_block(const void *data, void *address, size_t length);
+
+#endif /* HOST_AVR_EEPROM_H_ */
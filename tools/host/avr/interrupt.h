@@ -0,0 +1,17 @@
+/*
+ *	avr/interrupt.h for the host build, see board.h.
+ *
+ *	A handler is an ordinary function named after its vector, which the
+ *	board calls when the interrupt is due.
+ */
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define ISR(vector, ...) void vector(void)
+
+#define sei() ((void) 0)
+#define cli() ((void) 0)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
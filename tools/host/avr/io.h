@@ -0,0 +1,37 @@
+/*
+ *	avr/io.h for the host build, see board.h.
+ *
+ *	The registers the game and the library use are plain variables. The
+ *	board moves the timer and calls the interrupt handlers, the harness
+ *	sets the pins.
+ */
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+extern volatile uint8_t PINB, DDRB, PORTB;
+extern volatile uint8_t PIND, DDRD, PORTD;
+extern volatile uint8_t PINF, DDRF, PORTF;
+extern volatile uint8_t CLKPR, SREG;
+extern volatile uint8_t TCCR0A, TCCR0B, TCNT0, TIMSK0;
+extern volatile uint8_t TCCR3A, TCCR3B, TIMSK3;
+extern volatile uint16_t OCR3A;
+extern volatile uint8_t PCMSK0, PCICR, EICRA, EIMSK;
+
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT7 7
+#define PCIE0 0
+#define ISC00 0
+#define ISC10 2
+#define INT0 0
+#define INT1 1
+#define WGM32 3
+#define CS31 1
+#define OCIE3A 1
+#define TOIE0 0
+
+#define E2END 0x3FF
+
+#endif /* HOST_AVR_IO_H_ */
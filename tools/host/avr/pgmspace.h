@@ -0,0 +1,21 @@
+/*
+ *	avr/pgmspace.h for the host build, flash is ordinary memory.
+ */
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+#define pgm_read_dword(address) (*(const uint32_t *) (address))
+#define pgm_read_float(address) (*(const float *) (address))
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
@@ -0,0 +1,12 @@
+/*
+ *	avr/sleep.h for the host build, sleeping runs the board to the next
+ *	interrupt.
+ */
+#ifndef HOST_AVR_SLEEP_H_
+#define HOST_AVR_SLEEP_H_
+
+void board_sleep(void);
+
+#define sleep_mode() board_sleep()
+
+#endif /* HOST_AVR_SLEEP_H_ */
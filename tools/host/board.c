@@ -0,0 +1,323 @@
+/*
+ *	board.c
+ *
+ *	The simulated Teensy, see board.h. Also the computer versions of the
+ *	LCD, ADC, USB serial, EEPROM and RAM functions the game links with.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include <avr/eeprom.h>
+
+#include "board.h"
+#include "backlight.h"
+#include "cab202_adc.h"
+#include "input.h"
+#include "ram_utils.h"
+#include "usb_serial.h"
+
+/*
+ *  Timer 0 counts every 1024 cycles, the input timer interrupts every
+ *	millisecond and the backlight timer overflows every 64 * 1024 cycles.
+ */
+#define TIMER0_CYCLES 1024
+#define INPUT_CYCLES (F_CPU / 1000)
+#define BACKLIGHT_CYCLES (64 * (BACKLIGHT_MAX + 1))
+
+/*
+ *  Most chars the harness can send ahead of the game.
+ */
+#define SERIAL_IN_SIZE 65536
+
+/*
+ *  Interrupt handlers of the game and the library.
+ */
+void TIMER0_OVF_vect(void);
+void TIMER3_COMPA_vect(void);
+void PCINT0_vect(void);
+void INT0_vect(void);
+void INT1_vect(void);
+
+volatile uint8_t PINB, DDRB, PORTB;
+volatile uint8_t PIND, DDRD, PORTD;
+volatile uint8_t PINF, DDRF, PORTF;
+volatile uint8_t CLKPR, SREG;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, TIMSK0;
+volatile uint8_t TCCR3A, TCCR3B, TIMSK3;
+volatile uint16_t OCR3A;
+volatile uint8_t PCMSK0, PCICR, EICRA, EIMSK;
+
+uint64_t board_cycles;
+uint8_t board_lcd[LCD_X * LCD_Y / 8];
+bool board_lcd_inverse;
+FILE *board_serial;
+
+static uint8_t lcd_x, lcd_bank;
+static bool lcd_extended;
+static uint16_t pots[2];
+static uint8_t eeprom[E2END + 1];
+static char serial_in[SERIAL_IN_SIZE];
+static size_t serial_head, serial_tail;
+static uint64_t starved_since;
+
+/*
+ *  Port and bit of each input_t.
+ */
+static volatile uint8_t * const input_ports[INPUT_COUNT] = {
+	&PINB, &PINB, &PINB, &PIND, &PIND, &PINF, &PINF,
+};
+static const uint8_t input_bits[INPUT_COUNT] = { 0, 1, 7, 0, 1, 5, 6 };
+
+void board_reset(void) {
+	board_cycles = 0;
+	TCNT0 = 0;
+	PINB = PIND = PINF = 0;
+	PORTB = PORTD = PORTF = 0;
+	TIMSK0 = TIMSK3 = 0;
+	PCICR = EIMSK = 0;
+	memset(board_lcd, 0, sizeof(board_lcd));
+	board_lcd_inverse = false;
+	lcd_x = lcd_bank = 0;
+	lcd_extended = false;
+	pots[0] = pots[1] = 512;
+	memset(eeprom, 0xFF, sizeof(eeprom));
+	serial_head = serial_tail = 0;
+	starved_since = 0;
+}
+
+/*
+ *  Get the cycle at which something that happens every period cycles
+ *	next happens after now.
+ */
+static uint64_t next_multiple(uint64_t now, uint64_t period) {
+	return (now / period + 1) * period;
+}
+
+void board_run(uint64_t cycles) {
+	uint64_t end = board_cycles + cycles;
+
+	for ( ;; ) {
+		uint64_t timer0 = next_multiple(board_cycles, TIMER0_CYCLES * 256);
+		uint64_t input = next_multiple(board_cycles, INPUT_CYCLES);
+		uint64_t backlight = next_multiple(board_cycles, BACKLIGHT_CYCLES);
+		uint64_t next = timer0;
+
+		if ( input < next ) next = input;
+		if ( backlight < next ) next = backlight;
+		if ( next > end ) break;
+
+		board_cycles = next;
+		TCNT0 = board_cycles / TIMER0_CYCLES;
+
+		if ( next == timer0 && (TIMSK0 & (1 << TOIE0)) ) {
+			TIMER0_OVF_vect();
+		}
+		if ( next == input && (TIMSK3 & (1 << OCIE3A)) ) {
+			TIMER3_COMPA_vect();
+		}
+		if ( next == backlight ) {
+			backlight_tick();
+		}
+	}
+
+	board_cycles = end;
+	TCNT0 = board_cycles / TIMER0_CYCLES;
+}
+
+void board_sleep(void) {
+	if ( serial_head != serial_tail ) {
+		starved_since = board_cycles;
+	}
+	else if ( board_cycles - starved_since > (uint64_t) BOARD_STARVED_MS * INPUT_CYCLES ) {
+		fprintf(stderr, "the game waits for serial input that is never sent\n");
+		exit(3);
+	}
+
+	board_run(next_multiple(board_cycles, INPUT_CYCLES) - board_cycles);
+}
+
+void board_set_input(uint8_t input, bool held) {
+	volatile uint8_t *port = input_ports[input];
+	uint8_t bit = 1 << input_bits[input];
+	uint8_t before = *port;
+
+	*port = held ? before | bit : before & ~bit;
+	if ( *port == before ) {
+		return;
+	}
+
+	// The edge interrupts of the Teensy, the buttons on PORTF have none.
+	if ( port == &PINB && (PCICR & (1 << PCIE0)) && (PCMSK0 & bit) ) {
+		PCINT0_vect();
+	}
+	else if ( port == &PIND && input_bits[input] == 0 && (EIMSK & (1 << INT0)) ) {
+		INT0_vect();
+	}
+	else if ( port == &PIND && input_bits[input] == 1 && (EIMSK & (1 << INT1)) ) {
+		INT1_vect();
+	}
+}
+
+void board_set_pot(uint8_t channel, uint16_t value) {
+	pots[channel] = value;
+}
+
+void board_send(const char *text, size_t length) {
+	for ( size_t i = 0; i < length; i++ ) {
+		size_t next = (serial_head + 1) % SERIAL_IN_SIZE;
+
+		if ( next == serial_tail ) {
+			fprintf(stderr, "too much serial input at once\n");
+			exit(3);
+		}
+		serial_in[serial_head] = text[i];
+		serial_head = next;
+	}
+}
+
+size_t board_unread(void) {
+	return (serial_head + SERIAL_IN_SIZE - serial_tail) % SERIAL_IN_SIZE;
+}
+
+bool board_led(uint8_t pin) {
+	return (PORTB >> pin) & 1;
+}
+
+/*
+ *  The PCD8544 LCD: commands set the address or the display mode, data
+ *	is written at the address, which moves on a column at a time.
+ */
+void lcd_init(uint8_t contrast) {
+	lcd_clear();
+}
+
+void lcd_write(uint8_t dc, uint8_t data) {
+	if ( dc == LCD_D ) {
+		board_lcd[lcd_bank * LCD_X + lcd_x] = data;
+		if ( ++lcd_x == LCD_X ) {
+			lcd_x = 0;
+			lcd_bank = (lcd_bank + 1) % (LCD_Y / 8);
+		}
+	}
+	else if ( (data & 0xF8) == 0x20 ) {
+		// function set, the extended commands are for the bias and contrast
+		lcd_extended = data & 1;
+	}
+	else if ( lcd_extended ) {
+		return;
+	}
+	else if ( data & 0x80 ) {
+		lcd_x = (data & 0x7F) % LCD_X;
+	}
+	else if ( data & 0x40 ) {
+		lcd_bank = (data & 0x07) % (LCD_Y / 8);
+	}
+	else if ( (data & 0xF8) == 0x08 ) {
+		board_lcd_inverse = (data & 0x05) == 0x05;
+	}
+}
+
+void lcd_clear(void) {
+	memset(board_lcd, 0, sizeof(board_lcd));
+	lcd_x = lcd_bank = 0;
+}
+
+void lcd_position(uint8_t x, uint8_t y) {
+	lcd_x = x % LCD_X;
+	lcd_bank = y % (LCD_Y / 8);
+}
+
+/*
+ *  The ADC samples in the background on the Teensy, here the latest
+ *	sample is the pot as the harness left it.
+ */
+void adc_init() {
+}
+
+void adc_start_sampling(uint8_t channels) {
+}
+
+uint16_t adc_read(uint8_t channel) {
+	return pots[channel & 1];
+}
+
+uint16_t adc_latest(uint8_t channel) {
+	return pots[channel & 1];
+}
+
+/*
+ *  USB serial, configured as soon as it starts.
+ */
+void usb_init(void) {
+}
+
+uint8_t usb_configured(void) {
+	return 1;
+}
+
+int16_t usb_serial_getchar(void) {
+	if ( serial_head == serial_tail ) {
+		return -1;
+	}
+
+	uint8_t c = serial_in[serial_tail];
+	serial_tail = (serial_tail + 1) % SERIAL_IN_SIZE;
+	return c;
+}
+
+int8_t usb_serial_putchar(uint8_t c) {
+	if ( board_serial != NULL ) {
+		fputc(c, board_serial);
+	}
+	return 0;
+}
+
+int8_t usb_serial_write(const uint8_t *buffer, uint16_t size) {
+	if ( board_serial != NULL ) {
+		fwrite(buffer, 1, size, board_serial);
+	}
+	return 0;
+}
+
+/*
+ *  EEPROM, erased when the board is reset.
+ */
+uint8_t eeprom_read_byte(const uint8_t *address) {
+	return eeprom[(uintptr_t) address % sizeof(eeprom)];
+}
+
+void eeprom_read_block(void *data, const void *address, size_t length) {
+	for ( size_t i = 0; i < length; i++ ) {
+		((uint8_t *) data)[i] = eeprom[((uintptr_t) address + i) % sizeof(eeprom)];
+	}
+}
+
+void eeprom_update_block(const void *data, void *address, size_t length) {
+	for ( size_t i = 0; i < length; i++ ) {
+		eeprom[((uintptr_t) address + i) % sizeof(eeprom)] = ((const uint8_t *) data)[i];
+	}
+}
+
+/*
+ *  There is no Teensy RAM to report on.
+ */
+uint16_t ram_data_size(void) {
+	return 0;
+}
+
+uint16_t ram_bss_size(void) {
+	return 0;
+}
+
+uint16_t ram_heap_size(void) {
+	return 0;
+}
+
+uint16_t ram_stack_peak(void) {
+	return 0;
+}
+
+uint16_t ram_stack_unused(void) {
+	return 0;
+}
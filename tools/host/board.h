@@ -0,0 +1,104 @@
+/*
+ *	board.h
+ *
+ *	A Teensy with the TeensyPewPew, simulated on the computer so the game
+ *	can be run without one. The game and the library are built for the
+ *	computer against the avr/ and util/ headers in this folder:
+ *
+ *	-	timer 0, the 1 ms input timer (timer 3) and the backlight timer
+ *		(timer 4) run from a cycle counter, and their interrupt handlers
+ *		are called when they are due. Time only passes in _delay_ms,
+ *		_delay_us and sleep_mode, so a run is the same every time.
+ *	-	the joystick and buttons are pins the harness sets, edges call the
+ *		pin change and external interrupt handlers as the Teensy would.
+ *	-	the LCD keeps what the game writes to it, the pots are values the
+ *		harness sets and USB serial is a buffer each way.
+ *
+ *	Doubles are 8 bytes and rand() is the C library's, so a game on the
+ *	computer is not the same game as on the Teensy for the same inputs.
+ */
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lcd.h"
+
+/*
+ *  Cycles counted since the board was switched on, at F_CPU.
+ */
+extern uint64_t board_cycles;
+
+/*
+ *  What the LCD shows, laid out like screen_buffer, and if the display
+ *	is inverted.
+ */
+extern uint8_t board_lcd[LCD_X * LCD_Y / 8];
+extern bool board_lcd_inverse;
+
+/*
+ *  Where the chars the game sends over USB go, or NULL to throw them away.
+ */
+extern FILE *board_serial;
+
+/*
+ *  Put the board in the state it has when it is switched on: time 0, no
+ *	input held, the pots in the middle, the LCD and USB empty and the
+ *	EEPROM erased.
+ */
+void board_reset(void);
+
+/*
+ *  Run the board for a number of cycles, calling every interrupt handler
+ *	that falls due.
+ *
+ *	Parameters:
+ *		cycles - Cycles at F_CPU.
+ */
+void board_run(uint64_t cycles);
+
+/*
+ *  Run the board to the next interrupt. Exits the program if the game
+ *	sleeps for BOARD_STARVED_MS waiting for serial input that was never
+ *	sent, as it would wait for ever.
+ */
+void board_sleep(void);
+
+#define BOARD_STARVED_MS 10000
+
+/*
+ *  Hold or let go of a joystick direction or button.
+ *
+ *	Parameters:
+ *		input - An input_t.
+ *		held - True to hold it.
+ */
+void board_set_input(uint8_t input, bool held);
+
+/*
+ *  Turn a pot.
+ *
+ *	Parameters:
+ *		channel - 0 for the left pot, 1 for the right one.
+ *		value - 0 to 1023.
+ */
+void board_set_pot(uint8_t channel, uint16_t value);
+
+/*
+ *  Send chars to the game over USB.
+ */
+void board_send(const char *text, size_t length);
+
+/*
+ *  Get the number of chars sent to the game it has not read yet.
+ */
+size_t board_unread(void);
+
+/*
+ *  Get if the LED on PB2 (left) or PB3 (right) is on.
+ */
+bool board_led(uint8_t pin);
+
+#endif /* BOARD_H_ */
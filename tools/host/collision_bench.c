@@ -0,0 +1,117 @@
+/*
+ *	collision_bench.c
+ *
+ *	Host tool run by "make collision_bench". It times collision_detection
+ *	of main.c with every object list full, and is built once with
+ *	COLLISION_BITMAP and once without, so the owner id bitmap can be
+ *	compared with testing each plasma against each target.
+ *
+ *		./collision_bench [layouts] [rounds]
+ *
+ *	Each layout puts every object at a random place on the screen above
+ *	the shield, and every plasma at a random place and angle. The layouts
+ *	are the same in both builds, so the hits counted must be too. The time
+ *	to copy a layout into the game is measured on its own and taken off.
+ */
+#define main teensy_main
+#include "../../main.c"
+#undef main
+
+#include <time.h>
+
+#include "board.h"
+
+static uint32_t layout_random = 2463534242u;
+
+static uint32_t next_random(void) {
+	layout_random ^= layout_random << 13;
+	layout_random ^= layout_random >> 17;
+	layout_random ^= layout_random << 5;
+	return layout_random;
+}
+
+static double random_between(int low, int high) {
+	return low + (next_random() % ((high - low) * 16)) / 16.0;
+}
+
+static void place(struct Object objects[], int count, int size) {
+	for ( int i = 0; i < count; i++ ) {
+		objects[i].x = random_between(0, LCD_X - size);
+		objects[i].y = random_between(0, SHIELD_Y - size);
+		objects[i].angle = random_between(-30, 30);
+	}
+}
+
+static void make_layout(struct GameState *game) {
+	init_game(game);
+	game->isPasued = false;
+
+	game->asteroid_counter = MAX_ASTEROID;
+	game->boulder_counter = MAX_BOULDER;
+	game->fragment_counter = MAX_FRAGMENT;
+	game->plasma_counter = MAX_PLASMA;
+	place(game->asteroid_list, MAX_ASTEROID, ASTEROID_SIZE);
+	place(game->boulder_list, MAX_BOULDER, 5);
+	place(game->fragment_list, MAX_FRAGMENT, 3);
+	for ( int i = 0; i < MAX_ASTEROID; i++ ) {
+		game->asteroid_frame[i] = next_random() % SPRITE_FRAMES;
+	}
+	for ( int i = 0; i < MAX_PLASMA; i++ ) {
+		game->plasma_list[i].x = random_between(0, LCD_X - 2);
+		game->plasma_list[i].y = random_between(0, SHIELD_Y);
+		game->plasma_list[i].angle = (int) random_between(-60, 60);
+	}
+}
+
+static double seconds_since(struct timespec *start) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+	int layout_count = argc > 1 ? atoi(argv[1]) : 1000;
+	int rounds = argc > 2 ? atoi(argv[2]) : 100;
+	struct timespec start;
+	long hits = 0;
+
+	if ( layout_count <= 0 || rounds <= 0 ) {
+		fprintf(stderr, "usage: %s [layouts] [rounds]\n", argv[0]);
+		return 2;
+	}
+
+	struct GameState *layouts = malloc(layout_count * sizeof(*layouts));
+	for ( int l = 0; l < layout_count; l++ ) {
+		make_layout(&layouts[l]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int r = 0; r < rounds; r++ ) {
+		for ( int l = 0; l < layout_count; l++ ) {
+			game_state = layouts[l];
+			hits += game_state.score;
+		}
+	}
+	double copying = seconds_since(&start);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for ( int r = 0; r < rounds; r++ ) {
+		for ( int l = 0; l < layout_count; l++ ) {
+			game_state = layouts[l];
+			srand(l);
+			reset_particles();
+			collision_detection(&game_state);
+			hits += game_state.score;
+		}
+	}
+	double detecting = seconds_since(&start) - copying;
+	long calls = (long) layout_count * rounds;
+
+	printf("%s: %d plasma, %d asteroids, %d boulders, %d fragments: %.0f ns a frame, score %ld\n",
+		COLLISION_BITMAP ? "bitmap" : "pairwise", MAX_PLASMA, MAX_ASTEROID, MAX_BOULDER,
+		MAX_FRAGMENT, detecting / calls * 1e9, hits / rounds);
+
+	free(layouts);
+	return 0;
+}
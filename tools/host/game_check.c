@@ -0,0 +1,434 @@
+/*
+ *	game_check.c
+ *
+ *	Host tool run by "make check" and "make golden". It runs the game on
+ *	the simulated board (board.h) through every input sequence in
+ *	Tests.txt and compares how each one ends with its golden file.
+ *
+ *		./game_check [-g] [-j jobs] Tests.txt golden out
+ *
+ *	A test with two input sequences ("... OR ...") is run once for each,
+ *	as test05a and test05b. Each run starts from a board just switched
+ *	on, takes each step of the sequence, lets 10 frames pass after it
+ *	and 40 more at the end, then writes what the game sent over USB, what
+ *	the LCD shows, the LEDs and the backlight to out/<name>.txt. With -g
+ *	it is written to golden/<name>.txt instead. Steps that need a person,
+ *	such as unplugging the Teensy, skip the run.
+ *
+ *	Runs are independent, so up to jobs of them (the number of CPUs by
+ *	default) run at once, each in its own process.
+ */
+#define main teensy_main
+#include "../../main.c"
+#undef main
+
+#include <ctype.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "board.h"
+
+/*
+ *  Frames run after each step, and after the last one.
+ */
+#define STEP_FRAMES 10
+#define END_FRAMES 40
+
+/*
+ *  Frames a joystick direction or button is held for when it is pressed.
+ */
+#define TAP_FRAMES 3
+
+/*
+ *  Most frames a step that waits for the game runs for.
+ */
+#define WAIT_FRAMES (20 * 60 * 20)
+
+#define FRAMES_PER_SECOND 20
+
+#define CASE_MAX 200
+#define TOKEN_MAX 64
+#define TOKENS_MAX 40
+
+/*
+ *  Exit status of a run that was skipped.
+ */
+#define STATUS_SKIPPED 77
+
+/*
+ *  One input sequence of a test.
+ */
+struct check_case {
+	char name[32];
+	int count;
+	char tokens[TOKENS_MAX][TOKEN_MAX];
+};
+
+static struct check_case cases[CASE_MAX];
+static int case_count;
+
+/*
+ *  Add the input sequences on an "Input Sequence" line of the test named
+ *	test.
+ */
+static void parse_sequences(const char *test, const char *line) {
+	int first = case_count;
+	struct check_case *current = NULL;
+
+	while ( *line ) {
+		if ( *line == '\'' ) {
+			const char *end = strchr(line + 1, '\'');
+
+			if ( end == NULL ) break;
+			if ( current == NULL ) {
+				if ( case_count == CASE_MAX ) return;
+				current = &cases[case_count++];
+				memset(current, 0, sizeof(*current));
+			}
+			if ( current->count < TOKENS_MAX && end - line - 1 < TOKEN_MAX ) {
+				memcpy(current->tokens[current->count++], line + 1, end - line - 1);
+			}
+			line = end + 1;
+		}
+		else if ( strncasecmp(line, "or", 2) == 0 && !isalpha((unsigned char) line[2]) ) {
+			current = NULL;
+			line += 2;
+		}
+		else {
+			line++;
+		}
+	}
+
+	for ( int i = first; i < case_count; i++ ) {
+		if ( case_count - first > 1 ) {
+			snprintf(cases[i].name, sizeof(cases[i].name), "%s%c", test, 'a' + i - first);
+		}
+		else {
+			snprintf(cases[i].name, sizeof(cases[i].name), "%s", test);
+		}
+	}
+}
+
+/*
+ *  Read the input sequences of every test. Tests are named after their
+ *	number, a number used twice is named test50_2 the second time.
+ */
+static bool read_tests(const char *path) {
+	char line[1024], test[24] = "";
+	int number, used[100] = { 0 };
+	FILE *file = fopen(path, "r");
+
+	if ( file == NULL ) {
+		perror(path);
+		return false;
+	}
+
+	while ( fgets(line, sizeof(line), file) != NULL ) {
+		const char *colon = strchr(line, ':');
+
+		if ( sscanf(line, "Test %d", &number) == 1 && number >= 0 && number < 100 ) {
+			if ( used[number]++ > 0 ) {
+				snprintf(test, sizeof(test), "test%02d_%d", number, used[number]);
+			}
+			else {
+				snprintf(test, sizeof(test), "test%02d", number);
+			}
+		}
+		else if ( strncmp(line, "Input Sequence", 14) == 0 && colon != NULL ) {
+			parse_sequences(test, colon + 1);
+		}
+	}
+
+	fclose(file);
+	return true;
+}
+
+static void run_frames(int count) {
+	for ( int i = 0; i < count; i++ ) {
+		run_frame(&game_state);
+	}
+}
+
+static void send_text(const char *text) {
+	board_send(text, strlen(text));
+}
+
+static void tap(uint8_t input) {
+	board_set_input(input, true);
+	run_frames(TAP_FRAMES);
+	board_set_input(input, false);
+}
+
+/*
+ *  Get the input_t of a "joystick ..." step, or -1.
+ */
+static int joystick_input(const char *direction) {
+	static const char *names[] = { "center", "left", "down", "right", "up" };
+
+	for ( int i = 0; i < 5; i++ ) {
+		if ( strcmp(direction, names[i]) == 0 ) {
+			return i;
+		}
+	}
+	if ( strcmp(direction, "centre") == 0 ) {
+		return INPUT_CENTRE;
+	}
+	return -1;
+}
+
+/*
+ *  Take one step of an input sequence.
+ *
+ *	Returns NULL, or why the step can not be taken here.
+ */
+static const char *take_step(const char *token) {
+	int seconds, input;
+
+	if ( strcmp(token, "enter") == 0 ) {
+		send_text("\r");
+	}
+	else if ( strcmp(token, "SW2") == 0 ) {
+		tap(INPUT_SW2);
+	}
+	else if ( strcmp(token, "SW3") == 0 ) {
+		tap(INPUT_SW3);
+	}
+	else if ( strncmp(token, "joystick ", 9) == 0 && (input = joystick_input(token + 9)) >= 0 ) {
+		tap(input);
+	}
+	else if ( strcmp(token, "keep w pressed") == 0 ) {
+		for ( int i = 0; i < 3 * FRAMES_PER_SECOND; i++ ) {
+			send_text("w");
+			run_frames(1);
+		}
+	}
+	else if ( strcmp(token, "keep joystick up pressed") == 0 ) {
+		board_set_input(INPUT_UP, true);
+		run_frames(3 * FRAMES_PER_SECOND);
+		board_set_input(INPUT_UP, false);
+	}
+	else if ( sscanf(token, "wait for %d second", &seconds) == 1 ) {
+		run_frames(seconds * FRAMES_PER_SECOND);
+	}
+	else if ( strcmp(token, "wait until the game is over") == 0 ) {
+		for ( int i = 0; i < WAIT_FRAMES && scene != SCENE_GAME_OVER; i++ ) {
+			run_frames(1);
+		}
+	}
+	else if ( strcmp(token, "wait for the asteroids to fall down") == 0 ) {
+		run_frames(1);
+		for ( int i = 0; i < WAIT_FRAMES && game_state.asteroid_counter > 0; i++ ) {
+			run_frames(1);
+		}
+	}
+	else if ( strncmp(token, "shot", 4) == 0 ) {
+		int score = game_state.score;
+
+		for ( int i = 0; i < WAIT_FRAMES && game_state.score == score; i++ ) {
+			send_text("w");
+			run_frames(1);
+		}
+	}
+	else if ( strcasecmp(token, "Left potentiometer to minimum position") == 0 ) {
+		board_set_pot(0, 0);
+	}
+	else if ( strcasecmp(token, "Left potentiometer to maximum position") == 0
+		|| strcasecmp(token, "Left potentiometer") == 0 ) {
+		board_set_pot(0, 1023);
+	}
+	else if ( strcasecmp(token, "right potentiometer to maximum") == 0 ) {
+		board_set_pot(1, 1023);
+	}
+	else if ( strcasecmp(token, "change right potentiometer") == 0 ) {
+		board_set_pot(1, 256);
+	}
+	else if ( strstr(token, "teensy") != NULL ) {
+		return "needs the Teensy unplugged";
+	}
+	else if ( strchr(token, ' ') == NULL ) {
+		// a command, or a number typed a digit at a time
+		send_text(token);
+	}
+	else {
+		return "unknown step";
+	}
+
+	run_frames(STEP_FRAMES);
+	return NULL;
+}
+
+/*
+ *  Write how the run ended.
+ */
+static void write_result(FILE *file, struct check_case *c, const char *serial, size_t length) {
+	fprintf(file, "%s:", c->name);
+	for ( int i = 0; i < c->count; i++ ) {
+		fprintf(file, " '%s'", c->tokens[i]);
+	}
+	fprintf(file, "\n\nserial:\n");
+	for ( size_t i = 0; i < length; i++ ) {
+		if ( serial[i] != '\r' ) {
+			fputc(serial[i], file);
+		}
+	}
+	if ( length > 0 && serial[length - 1] != '\n' ) {
+		fputc('\n', file);
+	}
+
+	fprintf(file, "\nscreen:%s\n", board_lcd_inverse ? " inverse" : "");
+	for ( int y = 0; y < LCD_Y; y++ ) {
+		for ( int x = 0; x < LCD_X; x++ ) {
+			fputc(board_lcd[(y >> 3) * LCD_X + x] & (1 << (y & 7)) ? '#' : '.', file);
+		}
+		fputc('\n', file);
+	}
+
+	fprintf(file, "\nleds: %d %d\n", board_led(2), board_led(3));
+	fprintf(file, "backlight: %u\n", backlight_level());
+}
+
+static bool same_file(const char *a, const char *b) {
+	FILE *fa = fopen(a, "rb");
+	FILE *fb = fopen(b, "rb");
+	bool same = fa != NULL && fb != NULL;
+
+	while ( same ) {
+		int ca = fgetc(fa);
+		int cb = fgetc(fb);
+
+		same = ca == cb;
+		if ( ca == EOF ) break;
+	}
+
+	if ( fa != NULL ) fclose(fa);
+	if ( fb != NULL ) fclose(fb);
+	return same;
+}
+
+/*
+ *  Run one input sequence, in its own process.
+ *
+ *	Returns the exit status: 0 if it ended as its golden file says, 1 if
+ *	not, STATUS_SKIPPED if it could not be run.
+ */
+static int run_case(struct check_case *c, const char *golden, const char *out, bool make_golden) {
+	char *serial = NULL;
+	size_t length = 0;
+	char path[512], golden_path[512];
+
+	board_reset();
+	board_serial = open_memstream(&serial, &length);
+	start_up(&game_state);
+	run_frames(STEP_FRAMES);
+
+	for ( int i = 0; i < c->count; i++ ) {
+		const char *reason = take_step(c->tokens[i]);
+
+		if ( reason != NULL ) {
+			printf("%s: skipped, '%s' %s\n", c->name, c->tokens[i], reason);
+			return STATUS_SKIPPED;
+		}
+	}
+	run_frames(END_FRAMES);
+	fflush(board_serial);
+
+	snprintf(golden_path, sizeof(golden_path), "%s/%s.txt", golden, c->name);
+	snprintf(path, sizeof(path), "%s/%s.txt", make_golden ? golden : out, c->name);
+	FILE *file = fopen(path, "w");
+	if ( file == NULL ) {
+		perror(path);
+		return 1;
+	}
+	write_result(file, c, serial, length);
+	fclose(file);
+
+	if ( make_golden ) {
+		return 0;
+	}
+	if ( !same_file(golden_path, path) ) {
+		printf("%s: FAILED, diff -u %s %s\n", c->name, golden_path, path);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[]) {
+	bool make_golden = false;
+	long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	int option;
+
+	while ( (option = getopt(argc, argv, "gj:")) != -1 ) {
+		if ( option == 'g' ) {
+			make_golden = true;
+		}
+		else if ( option == 'j' ) {
+			jobs = atoi(optarg);
+		}
+		else {
+			break;
+		}
+	}
+	if ( argc - optind != 3 || jobs < 1 ) {
+		fprintf(stderr, "usage: %s [-g] [-j jobs] <Tests.txt> <golden dir> <out dir>\n", argv[0]);
+		return 2;
+	}
+
+	const char *golden = argv[optind + 1];
+	const char *out = argv[optind + 2];
+	if ( !read_tests(argv[optind]) ) {
+		return 2;
+	}
+	if ( mkdir(make_golden ? golden : out, 0777) != 0 && errno != EEXIST ) {
+		perror(make_golden ? golden : out);
+		return 2;
+	}
+	fflush(stdout);
+
+	static pid_t pids[CASE_MAX];
+	int running = 0, passed = 0, failed = 0, skipped = 0;
+	for ( int next = 0; next < case_count || running > 0; ) {
+		if ( next < case_count && running < jobs ) {
+			pid_t pid = fork();
+
+			if ( pid == 0 ) {
+				int status = run_case(&cases[next], golden, out, make_golden);
+				fflush(stdout);
+				_exit(status);
+			}
+			if ( pid < 0 ) {
+				perror("fork");
+				return 2;
+			}
+			pids[next++] = pid;
+			running++;
+			continue;
+		}
+
+		int status, done;
+		pid_t pid = wait(&status);
+		if ( pid < 0 ) {
+			perror("wait");
+			return 2;
+		}
+		for ( done = 0; done < next && pids[done] != pid; done++ ) {}
+		running--;
+		if ( WIFEXITED(status) && WEXITSTATUS(status) == 0 ) {
+			passed++;
+		}
+		else if ( WIFEXITED(status) && WEXITSTATUS(status) == STATUS_SKIPPED ) {
+			skipped++;
+		}
+		else {
+			if ( !WIFEXITED(status) || WEXITSTATUS(status) != 1 ) {
+				printf("%s: FAILED, the run stopped with status %d\n", cases[done].name, status);
+			}
+			failed++;
+		}
+	}
+
+	printf("%d runs: %d %s, %d failed, %d skipped\n", case_count, passed,
+		make_golden ? "written" : "passed", failed, skipped);
+	return failed > 0;
+}
@@ -0,0 +1,13 @@
+/*
+ *	util/atomic.h for the host build. Interrupts only run between the
+ *	game's own statements, so every block is atomic already.
+ */
+#ifndef HOST_UTIL_ATOMIC_H_
+#define HOST_UTIL_ATOMIC_H_
+
+#include <stdint.h>
+
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for ( uint8_t atomic_done = 0; !atomic_done; atomic_done = 1 )
+
+#endif /* HOST_UTIL_ATOMIC_H_ */
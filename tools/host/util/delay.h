@@ -0,0 +1,14 @@
+/*
+ *	util/delay.h for the host build, a delay runs the board for that long.
+ */
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+void board_run(uint64_t cycles);
+
+#define _delay_ms(ms) board_run((uint64_t) ((ms) * (F_CPU / 1000)))
+#define _delay_us(us) board_run((uint64_t) ((us) * (F_CPU / 1000000)))
+
+#endif /* HOST_UTIL_DELAY_H_ */
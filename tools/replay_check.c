@@ -0,0 +1,187 @@
+/*
+ *	replay_check.c
+ *
+ *	Host tool run by "make board_check" and "make board_golden" to replay a
+ *	recording on the Teensy and print the state dumps it sends back.
+ *
+ *		cc -std=gnu99 replay_check.c -o replay_check
+ *		./replay_check /dev/ttyACM0 session.rec > session.out
+ *
+ *	A recording is what the game sends between 'v' and 'v': a "#S" line
+ *	with the seed, a "#F" line for every frame and "#E". The tool sends
+ *	'y', then the recording, and prints every dump ('x' pressed while
+ *	recording), from its "#X" line to its "#L" line, until the game sends
+ *	"#E" to say the replay is over. The game must be on the playing
+ *	screen, where 'y' is taken. Everything else the game sends is
+ *	left out, so two runs of the same recording print the same text.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+
+/*
+ *  Seconds to wait for the game to send anything before giving up.
+ */
+#define REPLAY_TIMEOUT 30
+
+/*
+ *  Longest line the game sends, the "#L" line of the screen.
+ */
+#define LINE_MAX 1100
+
+static int open_port(const char *path) {
+	struct termios tio;
+	int fd = open(path, O_RDWR | O_NOCTTY);
+
+	if ( fd < 0 ) {
+		return -1;
+	}
+
+	if ( tcgetattr(fd, &tio) == 0 ) {
+		cfmakeraw(&tio);
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	tcflush(fd, TCIOFLUSH);
+
+	return fd;
+}
+
+/*
+ *  Lines of the game are put together here a char at a time.
+ */
+static char line[LINE_MAX];
+static size_t line_length;
+static bool in_dump;
+
+/*
+ *  Take a char from the game, printing the dump lines.
+ *
+ *	Returns true once the game has sent "#E".
+ */
+static bool take_char(char c) {
+	if ( c == '\r' ) {
+		return false;
+	}
+	if ( c != '\n' ) {
+		if ( line_length + 1 < sizeof(line) ) {
+			line[line_length++] = c;
+		}
+		return false;
+	}
+
+	line[line_length] = '\0';
+	line_length = 0;
+
+	if ( strcmp(line, "#E") == 0 && !in_dump ) {
+		return true;
+	}
+	if ( strcmp(line, "#X") == 0 ) {
+		in_dump = true;
+	}
+	if ( in_dump ) {
+		printf("%s\n", line);
+	}
+	if ( strncmp(line, "#L", 2) == 0 ) {
+		in_dump = false;
+	}
+
+	return false;
+}
+
+/*
+ *  Read the recording after the 'y' that starts a replay, keeping only
+ *	its "#S", "#F" and "#E" lines. Dumps sent while it was recorded are
+ *	left out, the game would take them for the end of the replay.
+ */
+static size_t read_recording(FILE *file, char *text, size_t size) {
+	size_t length = 1;
+	char buffer[LINE_MAX];
+
+	text[0] = 'y';
+	while ( fgets(buffer, sizeof(buffer), file) != NULL ) {
+		size_t n = strlen(buffer);
+
+		if ( buffer[0] != '#' || strchr("SFE", buffer[1]) == NULL ) continue;
+		if ( length + n > size ) return 0;
+		memcpy(text + length, buffer, n);
+		length += n;
+	}
+
+	return length;
+}
+
+int main(int argc, char *argv[]) {
+	static char recording[1 << 22];
+
+	if ( argc != 3 ) {
+		fprintf(stderr, "usage: %s <serial port> <recording>\n", argv[0]);
+		return 2;
+	}
+
+	FILE *file = fopen(argv[2], "r");
+	if ( file == NULL ) {
+		perror(argv[2]);
+		return 2;
+	}
+	size_t length = read_recording(file, recording, sizeof(recording));
+	fclose(file);
+	if ( length == 0 ) {
+		fprintf(stderr, "%s: recording too long\n", argv[2]);
+		return 2;
+	}
+
+	int port = open_port(argv[1]);
+	if ( port < 0 ) {
+		perror(argv[1]);
+		return 2;
+	}
+
+	// The game reads the recording a frame at a time as it replays, so it
+	// is sent as the port takes it while the dumps are read back.
+	size_t sent = 0;
+	for ( ;; ) {
+		fd_set reads, writes;
+		struct timeval timeout = { REPLAY_TIMEOUT, 0 };
+		char buffer[256];
+
+		FD_ZERO(&reads);
+		FD_ZERO(&writes);
+		FD_SET(port, &reads);
+		if ( sent < length ) {
+			FD_SET(port, &writes);
+		}
+
+		int ready = select(port + 1, &reads, &writes, NULL, &timeout);
+		if ( ready < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( ready <= 0 ) {
+			fprintf(stderr, "%s: no end of replay from the game\n", argv[0]);
+			return 1;
+		}
+
+		if ( FD_ISSET(port, &writes) ) {
+			ssize_t n = write(port, recording + sent, length - sent);
+			if ( n > 0 ) sent += n;
+		}
+
+		if ( FD_ISSET(port, &reads) ) {
+			ssize_t n = read(port, buffer, sizeof(buffer));
+			if ( n <= 0 ) {
+				perror(argv[1]);
+				return 2;
+			}
+			for ( ssize_t i = 0; i < n; i++ ) {
+				if ( take_char(buffer[i]) ) {
+					close(port);
+					return 0;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+ *	rotate_sprites.c
+ *
+ *	Host tool run by the Makefile to build asteroid_frames.h, so the game
+ *	gets its rotation frames from flash and never rotates at run time.
+ *
+ *		cc -std=c99 rotate_sprites.c -lm -o rotate_sprites
+ *		./rotate_sprites > asteroid_frames.h
+ *
+ *	Each sprite is rotated about its centre in FRAMES even steps, taking
+ *	the nearest source pixel for each pixel of the frame. Frames are packed
+ *	one byte a row, bit n set for a pixel in column n, so sprites may be
+ *	at most 8 pixels wide.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#define FRAMES 8
+
+/*
+ *  A square sprite drawn the way main.c draws its shapes.
+ */
+typedef struct sprite_t {
+	const char *name;
+	int size;
+	const char *pixels;
+} sprite_t;
+
+static const sprite_t sprites[] = {
+	{ "asteroid", 7,
+		"  ...  "
+		" ..... "
+		"......."
+		"......."
+		" ..... "
+		"  ...  "
+		"   .   " },
+};
+
+#define SPRITE_COUNT (sizeof(sprites) / sizeof(sprites[0]))
+
+/*
+ *  Get a pixel of the sprite, clear if outside it.
+ */
+static int sprite_pixel(const sprite_t *sprite, int x, int y) {
+	if ( x < 0 || x >= sprite->size || y < 0 || y >= sprite->size ) {
+		return 0;
+	}
+	return sprite->pixels[x + y * sprite->size] != ' ';
+}
+
+/*
+ *  Get one row of a frame, each pixel taken from where it is rotated back
+ *	to in the sprite.
+ */
+static unsigned rotated_row(const sprite_t *sprite, int frame, int y) {
+	double angle = 2 * acos(-1) * frame / FRAMES;
+	double c = (sprite->size - 1) / 2.0;
+	unsigned row = 0;
+
+	for ( int x = 0; x < sprite->size; x++ ) {
+		double sx = c + (x - c) * cos(angle) + (y - c) * sin(angle);
+		double sy = c - (x - c) * sin(angle) + (y - c) * cos(angle);
+
+		if ( sprite_pixel(sprite, (int) floor(sx + 0.5), (int) floor(sy + 0.5)) ) {
+			row |= 1u << x;
+		}
+	}
+
+	return row;
+}
+
+int main(void) {
+	printf("// Generated by tools/rotate_sprites.c, do not edit.\n");
+	printf("// Frames are one byte a row, bit n set for a pixel in column n.\n");
+	printf("#define SPRITE_FRAMES %d\n", FRAMES);
+
+	for ( unsigned s = 0; s < SPRITE_COUNT; s++ ) {
+		const sprite_t *sprite = &sprites[s];
+
+		if ( sprite->size > 8 ) {
+			fprintf(stderr, "%s is wider than 8 pixels\n", sprite->name);
+			return 1;
+		}
+
+		printf("\n#define ");
+		for ( const char *c = sprite->name; *c; c++ ) {
+			putchar(toupper((unsigned char) *c));
+		}
+		printf("_SIZE %d\n", sprite->size);
+		printf("const uint8_t %s_frames[SPRITE_FRAMES * %d] PROGMEM = {\n",
+			sprite->name, sprite->size);
+
+		for ( int frame = 0; frame < FRAMES; frame++ ) {
+			printf("    // %d degrees\n   ", 360 * frame / FRAMES);
+			for ( int y = 0; y < sprite->size; y++ ) {
+				printf(" 0x%02X,", rotated_row(sprite, frame, y));
+			}
+			printf("\n");
+		}
+
+		printf("};\n");
+	}
+
+	return 0;
+}
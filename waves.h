@@ -0,0 +1,30 @@
+// The asteroid waves, in flash on the Teensy. tools/batch_sim.c plays
+// them through main.c itself, so balancing runs play the game's waves.
+
+#ifndef WAVES_H_
+#define WAVES_H_
+
+#include <stdint.h>
+
+// one wave of asteroids, read from the waves table in flash
+struct Wave{
+    uint8_t asteroids;  // asteroids in the wave
+    uint8_t speed;      // how fast things fall, in tenths of the speed set
+    uint8_t pieces;     // boulders from an asteroid and fragments from a boulder, 1 or 2
+    uint8_t group;      // asteroids spawned side by side at once
+    uint8_t interval;   // frames between groups
+};
+
+// the waves in order, the last one repeats with WAVE_GROWTH more
+// asteroids each time
+const struct Wave waves[] PROGMEM = {
+    // asteroids, speed, pieces, group, interval
+    {3, 10, 2, 3, 0},
+    {4, 10, 2, 2, 30},
+    {6, 12, 2, 3, 40},
+    {8, 14, 2, 2, 25},
+    {12, 16, 2, 3, 30},
+};
+#define WAVE_COUNT (sizeof(waves) / sizeof(waves[0]))
+
+#endif /* WAVES_H_ */